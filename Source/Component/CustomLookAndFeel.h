@@ -244,13 +244,9 @@ public:
         auto lineW = juce::jmin(8.0f, radius * 0.5f);
         auto arcRadius = radius - lineW * 0.5f;
 
-        // Background arc
-        juce::Path backgroundArc;
-        backgroundArc.addCentredArc(bounds.getCentreX(), bounds.getCentreY(),
-                                   arcRadius, arcRadius, 0.0f,
-                                   rotaryStartAngle, rotaryEndAngle, true);
+        // Background arc, stroked once per knob geometry
         g.setColour(Colors::backgroundDark);
-        g.strokePath(backgroundArc, juce::PathStrokeType(lineW, juce::PathStrokeType::curved, juce::PathStrokeType::rounded));
+        g.fillPath(getBackgroundArc(bounds, arcRadius, lineW, rotaryStartAngle, rotaryEndAngle));
 
         // Value arc
         if (toAngle > rotaryStartAngle)
@@ -315,4 +311,38 @@ public:
             g.drawRoundedRectangle(bounds, cornerSize, 1.0f);
         }
     }
+
+private:
+    // Stroked rotary background arcs, keyed by geometry, so a knob repaint only fills a cached path
+    struct CachedArc
+    {
+        juce::Rectangle<float> bounds;
+        float startAngle, endAngle;
+        juce::Path stroke;
+    };
+    std::vector<CachedArc> arcCache;
+    static constexpr size_t maxCachedArcs = 16;
+
+    const juce::Path& getBackgroundArc(juce::Rectangle<float> bounds, float arcRadius, float lineW,
+                                       float rotaryStartAngle, float rotaryEndAngle)
+    {
+        for (const auto& arc : arcCache)
+            if (arc.bounds == bounds && arc.startAngle == rotaryStartAngle && arc.endAngle == rotaryEndAngle)
+                return arc.stroke;
+
+        if (arcCache.size() >= maxCachedArcs)
+            arcCache.erase(arcCache.begin());
+
+        juce::Path backgroundArc;
+        backgroundArc.addCentredArc(bounds.getCentreX(), bounds.getCentreY(),
+                                   arcRadius, arcRadius, 0.0f,
+                                   rotaryStartAngle, rotaryEndAngle, true);
+
+        juce::Path stroke;
+        juce::PathStrokeType(lineW, juce::PathStrokeType::curved, juce::PathStrokeType::rounded)
+            .createStrokedPath(stroke, backgroundArc);
+
+        arcCache.push_back({ bounds, rotaryStartAngle, rotaryEndAngle, std::move(stroke) });
+        return arcCache.back().stroke;
+    }
 };
\ No newline at end of file
@@ -94,6 +94,7 @@ XYPad::XYPad() : thumb(*this)
 
 void XYPad::resized()
 {
+	backgroundCache = {};
 	thumb.setBounds(getLocalBounds().withSizeKeepingCentre(thumbSize, thumbSize));
 	if (!xSliders.empty())
 		sliderValueChanged(xSliders[0]);
@@ -103,6 +104,25 @@ void XYPad::resized()
 
 void XYPad::paint(juce::Graphics& g)
 {
+	// Re-render only when the size, colours or display scale changed
+	const float scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+	if (!backgroundCache.isValid() || scale != backgroundCacheScale)
+		renderBackground(scale);
+
+	g.drawImageTransformed(backgroundCache, juce::AffineTransform::scale(1.0f / backgroundCacheScale));
+}
+
+void XYPad::renderBackground(float scale)
+{
+	backgroundCacheScale = scale;
+	backgroundCache = juce::Image(juce::Image::ARGB,
+	                              juce::jmax(1, juce::roundToInt(getWidth() * scale)),
+	                              juce::jmax(1, juce::roundToInt(getHeight() * scale)),
+	                              true);
+
+	juce::Graphics g(backgroundCache);
+	g.addTransform(juce::AffineTransform::scale(scale));
+
 	auto bounds = getLocalBounds().toFloat();
 
 	// Fill background
@@ -140,12 +160,13 @@ void XYPad::setThumbColours(juce::Colour pitchPos, juce::Colour pitchNeg,
 	pitchNegativeColour = pitchNeg;
 	formantPositiveColour = formantPos;
 	formantNegativeColour = formantNeg;
-	repaint();
+	thumb.repaint();
 }
 
 void XYPad::setBackgroundColour(juce::Colour colour)
 {
 	backgroundColour = colour;
+	backgroundCache = {};
 	repaint();
 }
 
@@ -172,7 +193,9 @@ void XYPad::sliderValueChanged(juce::Slider* slider)
 			thumb.getX(),
 			juce::jmap(slider->getValue(), slider->getMinimum(), slider->getMaximum(), bounds.getHeight() - w, 0.0));
 	}
-	repaint();
+
+	// Moving the thumb repaints its old and new area; its colour follows its position
+	thumb.repaint();
 }
 
 void XYPad::updateSlidersFromThumbPosition(juce::Point<double> thumbPos) const {
@@ -211,7 +234,7 @@ void XYPad::resetThumbToDefaultPosition()
 	// Update thumb position to match reset values
 	auto thumbPosition = calculateThumbPositionFromSliders();
 	thumb.setTopLeftPosition(thumbPosition);
-	repaint();
+	thumb.repaint();
 }
 
 juce::Point<int> XYPad::calculateThumbPositionFromSliders() const
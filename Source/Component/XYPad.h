@@ -8,6 +8,10 @@
 /**
  * XY Pad component that allows controlling two parameters simultaneously.
  * The thumb color interpolates between pitch and formant colors based on position.
+ *
+ * The static background is rendered once into an image at the display's
+ * pixel scale and only redrawn on resize, scale or colour changes; moving
+ * the thumb repaints just the area it covers.
  */
 class XYPad : public juce::Component, juce::Slider::Listener
 {
@@ -78,6 +82,9 @@ private:
     void sliderValueChanged(juce::Slider* slider) override;
 
     // ===== Helper Methods =====
+    /** Renders the rounded background and border into backgroundCache at the given pixel scale. */
+    void renderBackground(float scale);
+
     /** Updates registered sliders based on thumb position. */
     void updateSlidersFromThumbPosition(juce::Point<double> thumbPos) const;
 
@@ -92,6 +99,10 @@ private:
     Thumb thumb;
     std::mutex vectorMutex;
 
+    // Cached background layer, in physical pixels
+    juce::Image backgroundCache;
+    float backgroundCacheScale = 0.0f;
+
     // ===== Constants =====
     static constexpr int thumbSize = 40;
     static constexpr float cornerRadius = 20.0f;
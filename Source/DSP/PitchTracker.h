@@ -0,0 +1,249 @@
+//
+// YIN fundamental frequency tracker
+//
+
+#pragma once
+#include <juce_dsp/juce_dsp.h>
+#include "../Utility/DspArena.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+/**
+ * Low-cost real-time fundamental frequency (f0) tracker based on YIN.
+ *
+ * The mono input is low-passed and decimated to roughly 11 kHz before
+ * analysis, which keeps the O(window * lag) difference function cheap while
+ * still covering the range of sung and spoken fundamentals.
+ *
+ * Implementation details:
+ * - Decimated rate: ~11 kHz (integer decimation factor)
+ * - Window: 256 decimated samples, hop: 256 decimated samples (~23 ms)
+ * - Search range: 50 Hz to 1 kHz
+ * - Difference function computed from running energies plus a dot product
+ *   (auto-vectorised inner loop)
+ * - Median-of-three outlier rejection, then ~120 ms one-pole smoothing
+ *
+ * Unvoiced or silent frames leave the last valid estimate in place, so the
+ * value fed to the formant estimator doesn't jump around between phrases.
+ */
+class PitchTracker
+{
+public:
+    PitchTracker() = default;
+
+    /** Arena space needed by prepare() at this sample rate. */
+    static size_t getArenaBytes(double sampleRate)
+    {
+        const int lags = getMaxLag(sampleRate / getDecimation(sampleRate));
+        return DspArena::bytesFor<float>(static_cast<size_t>(windowSize + lags + 1))
+             + DspArena::bytesFor<float>(static_cast<size_t>(lags + 1));
+    }
+
+    void prepare(double sampleRate, int maxBlockSize, DspArena& arena)
+    {
+        juce::ignoreUnused(maxBlockSize);
+
+        this->sampleRate = sampleRate;
+
+        decimation = getDecimation(sampleRate);
+        decimatedRate = sampleRate / decimation;
+
+        minLag = juce::jmax(2, static_cast<int>(std::floor(decimatedRate / maxF0Hz)));
+        maxLag = getMaxLag(decimatedRate);
+
+        historyLength = windowSize + maxLag + 1;
+        history = arena.allocate<float>(static_cast<size_t>(historyLength));
+        difference = arena.allocate<float>(static_cast<size_t>(maxLag + 1));
+
+        // One-pole anti-aliasing filter at a quarter of the decimated rate
+        const double cutoffHz = decimatedRate * 0.25;
+        lowpassCoeff = static_cast<float>(1.0 - std::exp(-juce::MathConstants<double>::twoPi * cutoffHz / sampleRate));
+
+        // Smoothing is applied once per hop
+        const float timeConstantSeconds = 0.12f;
+        const float updateRateHz = static_cast<float>(decimatedRate) / hopSize;
+        smoothingCoeff = std::exp(-1.0f / (timeConstantSeconds * updateRateHz));
+
+        reset();
+    }
+
+    void reset()
+    {
+        if (history == nullptr)
+            return;
+
+        std::fill_n(history, historyLength, 0.0f);
+        std::fill_n(difference, maxLag + 1, 0.0f);
+        writePosition = 0;
+        decimationCounter = 0;
+        decimationSum = 0.0f;
+        lowpassState = 0.0f;
+        recentEstimates.fill(0.0f);
+        numRecentEstimates = 0;
+        smoothedF0Hz = 0.0f;
+        voiced = false;
+    }
+
+    void processBlock(const float* monoBuffer, int numSamples)
+    {
+        for (int i = 0; i < numSamples; ++i)
+        {
+            lowpassState += lowpassCoeff * (monoBuffer[i] - lowpassState);
+            decimationSum += lowpassState;
+
+            if (++decimationCounter < decimation)
+                continue;
+
+            history[static_cast<size_t>(writePosition++)] = decimationSum / static_cast<float>(decimation);
+            decimationCounter = 0;
+            decimationSum = 0.0f;
+
+            if (writePosition == historyLength)
+            {
+                analyse();
+
+                // Slide the analysis window forward by one hop
+                std::copy(history + hopSize, history + historyLength, history);
+                writePosition -= hopSize;
+            }
+        }
+    }
+
+    /** Returns the smoothed f0 in Hz, or 0 if nothing has been detected yet. */
+    float getFrequencyHz() const
+    {
+        return smoothedF0Hz;
+    }
+
+    /** Returns true if the most recent analysis frame was voiced. */
+    bool isVoiced() const
+    {
+        return voiced;
+    }
+
+private:
+    static constexpr double targetRateHz = 11025.0;
+    static constexpr double minF0Hz = 50.0;
+    static constexpr double maxF0Hz = 1000.0;
+    static constexpr int windowSize = 256;
+    static constexpr int hopSize = 256;
+    static constexpr float yinThreshold = 0.15f;
+    static constexpr float energyThreshold = 1e-5f; // Mean-square level below which frames are treated as silence
+
+    // Arena-owned buffers, assigned in prepare()
+    float* history = nullptr;       // windowSize + maxLag decimated samples
+    float* difference = nullptr;    // Cumulative mean normalised difference, indexed by lag
+    int historyLength = 0;
+
+    double sampleRate = 44100.0;
+    double decimatedRate = 11025.0;
+    int decimation = 4;
+    int minLag = 11;
+    int maxLag = 221;
+
+    int writePosition = 0;
+    int decimationCounter = 0;
+    float decimationSum = 0.0f;
+    float lowpassState = 0.0f;
+    float lowpassCoeff = 0.0f;
+
+    std::array<float, 3> recentEstimates {};
+    int numRecentEstimates = 0;
+    float smoothedF0Hz = 0.0f;
+    float smoothingCoeff = 0.0f;
+    bool voiced = false;
+
+    static int getDecimation(double rate)
+    {
+        return juce::jmax(1, juce::roundToInt(rate / targetRateHz));
+    }
+
+    static int getMaxLag(double rateAfterDecimation)
+    {
+        return static_cast<int>(std::ceil(rateAfterDecimation / minF0Hz));
+    }
+
+    void analyse()
+    {
+        const float* x = history;
+
+        float energyStart = 0.0f;
+        for (int j = 0; j < windowSize; ++j)
+            energyStart += x[j] * x[j];
+
+        if (energyStart < energyThreshold * windowSize)
+        {
+            voiced = false;
+            return;
+        }
+
+        // d(tau) = e(0) + e(tau) - 2 r(tau), with e(tau) updated incrementally
+        float energyLagged = energyStart;
+        float runningSum = 0.0f;
+        difference[0] = 1.0f;
+
+        for (int tau = 1; tau <= maxLag; ++tau)
+        {
+            energyLagged += x[tau + windowSize - 1] * x[tau + windowSize - 1]
+                          - x[tau - 1] * x[tau - 1];
+
+            const float* lagged = x + tau;
+            float correlation = 0.0f;
+            for (int j = 0; j < windowSize; ++j)
+                correlation += x[j] * lagged[j];
+
+            const float d = juce::jmax(0.0f, energyStart + energyLagged - 2.0f * correlation);
+            runningSum += d;
+            difference[static_cast<size_t>(tau)] = d * static_cast<float>(tau) / (runningSum + 1e-12f);
+        }
+
+        // First dip below the threshold, then walk down to its local minimum
+        int bestLag = -1;
+        for (int tau = minLag; tau < maxLag; ++tau)
+        {
+            if (difference[static_cast<size_t>(tau)] < yinThreshold)
+            {
+                while (tau + 1 < maxLag && difference[static_cast<size_t>(tau + 1)] < difference[static_cast<size_t>(tau)])
+                    ++tau;
+                bestLag = tau;
+                break;
+            }
+        }
+
+        if (bestLag < 0)
+        {
+            voiced = false;
+            return;
+        }
+
+        // Parabolic interpolation around the minimum
+        const float left   = difference[static_cast<size_t>(bestLag - 1)];
+        const float centre = difference[static_cast<size_t>(bestLag)];
+        const float right  = difference[static_cast<size_t>(bestLag + 1)];
+        const float denominator = left - 2.0f * centre + right;
+        float refinedLag = static_cast<float>(bestLag);
+        if (std::abs(denominator) > 1e-9f)
+            refinedLag += juce::jlimit(-0.5f, 0.5f, 0.5f * (left - right) / denominator);
+
+        const float rawF0Hz = static_cast<float>(decimatedRate) / refinedLag;
+        voiced = true;
+
+        // Median of the last three voiced estimates rejects single-frame octave errors
+        recentEstimates[static_cast<size_t>(numRecentEstimates % 3)] = rawF0Hz;
+        ++numRecentEstimates;
+
+        float estimate = rawF0Hz;
+        if (numRecentEstimates >= 3)
+        {
+            auto sorted = recentEstimates;
+            std::sort(sorted.begin(), sorted.end());
+            estimate = sorted[1];
+        }
+
+        if (smoothedF0Hz <= 0.0f)
+            smoothedF0Hz = estimate;
+        else
+            smoothedF0Hz = smoothingCoeff * smoothedF0Hz + (1.0f - smoothingCoeff) * estimate;
+    }
+};
@@ -7,6 +7,9 @@
 #include <juce_dsp/juce_dsp.h>
 #include <vector>
 #include <cmath>
+#include <memory>
+#include "../Utility/SharedResources.h"
+#include "../Utility/DspArena.h"
 
 /**
  * Real-time spectral centroid analyzer using overlapping FFT windows.
@@ -21,6 +24,9 @@
  * - Overlap: 75% (hop size = 512 samples)
  * - Temporal smoothing: ~250ms time constant
  * - Frequency range: 20 Hz to 20 kHz (clamped)
+ * - Window table is shared across instances (SharedResources); the FFT plan is
+ *   per instance, since JUCE's fallback FFT locks around each transform
+ * - Working buffers live in the owner's DspArena; nothing allocates per frame
  *
  * The centroid is only updated when sufficient energy is present in the
  * signal to avoid noise artifacts during silence.
@@ -30,18 +36,38 @@ class SpectralCentroid
 public:
     SpectralCentroid() = default;
 
-    void prepare(double sampleRate, int maxBlockSize)
+    /** Arena space needed by prepare(). */
+    static constexpr size_t getArenaBytes()
     {
+        return DspArena::bytesFor<float>(fftSize * 2)
+             + DspArena::bytesFor<float>(fftSize)
+             + DspArena::bytesFor<float>(numBins)
+             + DspArena::bytesFor<float>(numBins - 1) * 4;
+    }
+
+    void prepare(double sampleRate, int maxBlockSize, DspArena& arena)
+    {
+        juce::ignoreUnused(maxBlockSize);
+
         this->sampleRate = sampleRate;
 
-        // Initialize FFT buffers
-        fftBuffer.resize(fftSize * 2, 0.0f);  // Real + imaginary
-        inputBuffer.resize(fftSize, 0.0f);
-        magnitudes.resize(fftSize / 2 + 1, 0.0f);  // Only need positive frequencies
+        // Built once; the plan only depends on the order
+        if (fft == nullptr)
+            fft = std::make_unique<juce::dsp::FFT>(fftOrder);
+        window = &shared->getHannWindow(fftSize);
+
+        // Initialize FFT buffers (arena memory is zeroed)
+        fftBuffer = arena.allocate<float>(fftSize * 2);  // Real + imaginary
+        inputBuffer = arena.allocate<float>(fftSize);
+        magnitudes = arena.allocate<float>(numBins);  // Only need positive frequencies
+
+        // Scratch for the vectorised magnitude and centroid sums
+        realParts = arena.allocate<float>(numBins - 1);
+        imagParts = arena.allocate<float>(numBins - 1);
+        weightedMagnitudes = arena.allocate<float>(numBins - 1);
 
         // Pre-calculate bin frequencies (SIMD optimization)
-        const int numBins = fftSize / 2 + 1;
-        binFrequencies.resize(numBins - 1);  // Skip DC bin
+        binFrequencies = arena.allocate<float>(numBins - 1);  // Skip DC bin
         const float binWidthHz = static_cast<float>(sampleRate / fftSize);
         for (int bin = 1; bin < numBins; ++bin)
         {
@@ -52,11 +78,8 @@ public:
         writePosition = 0;
         samplesUntilNextFFT = hopSize;
 
-        // Update happens every hopSize samples
-        const float timeConstantMs = 800.0f;
-        const float timeConstantSeconds = timeConstantMs / 1000.0f;
-        const float updateRateHz = static_cast<float>(sampleRate) / hopSize;
-        smoothingCoeff = std::exp(-1.0f / (timeConstantSeconds * updateRateHz));
+        updateDivisor = 1;
+        updateSmoothing();
 
         // Initialize centroid values
         rawCentroidHz = 1000.0f;
@@ -65,15 +88,33 @@ public:
 
     void reset()
     {
-        std::fill(fftBuffer.begin(), fftBuffer.end(), 0.0f);
-        std::fill(inputBuffer.begin(), inputBuffer.end(), 0.0f);
-        std::fill(magnitudes.begin(), magnitudes.end(), 0.0f);
+        if (fftBuffer == nullptr)
+            return;
+
+        std::fill_n(fftBuffer, fftSize * 2, 0.0f);
+        std::fill_n(inputBuffer, fftSize, 0.0f);
+        std::fill_n(magnitudes, numBins, 0.0f);
         writePosition = 0;
         samplesUntilNextFFT = hopSize;
         rawCentroidHz = 1000.0f;
         smoothedCentroidHz = 1000.0f;
     }
 
+    /**
+     * Runs the FFT only every `divisor` hops, trading update rate for CPU.
+     * The smoothing is rescaled so the time constant stays the same.
+     */
+    void setUpdateDivisor(int divisor)
+    {
+        divisor = juce::jmax(1, divisor);
+        if (divisor == updateDivisor)
+            return;
+
+        updateDivisor = divisor;
+        samplesUntilNextFFT = juce::jmin(samplesUntilNextFFT, hopSize * updateDivisor);
+        updateSmoothing();
+    }
+
     void processBlock(const float* monoBuffer, int numSamples)
     {
         for (int i = 0; i < numSamples; ++i)
@@ -89,7 +130,7 @@ public:
             if (samplesUntilNextFFT <= 0)
             {
                 performFFTAndCalculate();
-                samplesUntilNextFFT = hopSize;  // Reset for next hop
+                samplesUntilNextFFT = hopSize * updateDivisor;  // Reset for next hop
             }
         }
     }
@@ -108,28 +149,41 @@ private:
     static constexpr int fftOrder = 11;        // 2^11 = 2048
     static constexpr int fftSize = 1 << fftOrder;
     static constexpr int hopSize = fftSize / 4; // 512 samples (75% overlap)
+    static constexpr int numBins = fftSize / 2 + 1;
     static constexpr float energyThreshold = 1e-6f; // Minimum energy to update centroid
 
-    juce::dsp::FFT fft { fftOrder };
-    juce::dsp::WindowingFunction<float> window {
-        fftSize,
-        juce::dsp::WindowingFunction<float>::hann,
-        false  // Don't normalize (we'll handle magnitude scaling)
-    };
+    // Own FFT plan; the window is shared and read-only. Both resolved in prepare()
+    juce::SharedResourcePointer<SharedResources> shared;
+    std::unique_ptr<juce::dsp::FFT> fft;
+    const juce::dsp::WindowingFunction<float>* window = nullptr;  // Hann, not normalised
 
-    std::vector<float> fftBuffer;
-    std::vector<float> inputBuffer;
-    std::vector<float> magnitudes;
-    std::vector<float> binFrequencies;  // Pre-calculated frequency for each bin
+    // Arena-owned buffers, assigned in prepare()
+    float* fftBuffer = nullptr;
+    float* inputBuffer = nullptr;
+    float* magnitudes = nullptr;
+    float* binFrequencies = nullptr;  // Pre-calculated frequency for each bin
+    float* realParts = nullptr;
+    float* imagParts = nullptr;
+    float* weightedMagnitudes = nullptr;
 
     int writePosition = 0;
     int samplesUntilNextFFT = hopSize;
+    int updateDivisor = 1;
 
     double sampleRate = 44100.0;
     float rawCentroidHz = 1000.0f;
     float smoothedCentroidHz = 1000.0f;
     float smoothingCoeff = 0.0f;
 
+    void updateSmoothing()
+    {
+        // Update happens every hopSize * updateDivisor samples
+        const float timeConstantMs = 800.0f;
+        const float timeConstantSeconds = timeConstantMs / 1000.0f;
+        const float updateRateHz = static_cast<float>(sampleRate) / static_cast<float>(hopSize * updateDivisor);
+        smoothingCoeff = std::exp(-1.0f / (timeConstantSeconds * updateRateHz));
+    }
+
     void performFFTAndCalculate()
     {
         // Copy from circular buffer to FFT buffer in correct order
@@ -141,10 +195,10 @@ private:
         }
 
         // Apply window function
-        window.multiplyWithWindowingTable(fftBuffer.data(), fftSize);
+        window->multiplyWithWindowingTable(fftBuffer, fftSize);
 
         // Perform FFT (real-to-complex)
-        fft.performRealOnlyForwardTransform(fftBuffer.data(), true);
+        fft->performRealOnlyForwardTransform(fftBuffer, true);
 
         // Calculate magnitudes from complex FFT output (SIMD optimized)
         calculateMagnitudesSIMD();
@@ -159,8 +213,6 @@ private:
 
     void calculateMagnitudes()
     {
-        const int numBins = fftSize / 2 + 1;
-
         for (int bin = 1; bin < numBins - 1; ++bin)
         {
             float real = fftBuffer[bin];
@@ -172,8 +224,6 @@ private:
 
     void calculateMagnitudesSIMD()
     {
-        const int numBins = fftSize / 2 + 1;
-
         // DC bin (bin 0) - always scalar
         magnitudes[0] = std::abs(fftBuffer[0]);
 
@@ -181,10 +231,6 @@ private:
         // Process 4 bins at a time using JUCE's FloatVectorOperations
         const int simdBins = numBins - 1;  // Exclude DC and Nyquist
 
-        // Prepare temporary buffers for SIMD processing
-        std::vector<float> realParts(simdBins);
-        std::vector<float> imagParts(simdBins);
-
         // Extract real and imaginary parts
         for (int bin = 1; bin < numBins - 1; ++bin)
         {
@@ -193,13 +239,13 @@ private:
         }
 
         // Square the real parts (in-place)
-        juce::FloatVectorOperations::multiply(realParts.data(), realParts.data(), simdBins);
+        juce::FloatVectorOperations::multiply(realParts, realParts, simdBins);
 
         // Square the imaginary parts (in-place)
-        juce::FloatVectorOperations::multiply(imagParts.data(), imagParts.data(), simdBins);
+        juce::FloatVectorOperations::multiply(imagParts, imagParts, simdBins);
 
         // Add squared components: real^2 + imag^2
-        juce::FloatVectorOperations::add(&magnitudes[1], realParts.data(), imagParts.data(), simdBins);
+        juce::FloatVectorOperations::add(&magnitudes[1], realParts, imagParts, simdBins);
 
         // Take square root to get magnitudes
         for (int bin = 1; bin < numBins - 1; ++bin)
@@ -216,15 +262,11 @@ private:
 
     float calculateCentroidFromMagnitudes()
     {
-        const int numBins = fftSize / 2 + 1;
-
         // SIMD-optimized weighted sum calculation
         // Use pre-calculated frequency array (set in prepare())
-        std::vector<float> weightedMagnitudes(numBins - 1);
-
         // Multiply pre-calculated frequencies by magnitudes (SIMD)
-        juce::FloatVectorOperations::multiply(weightedMagnitudes.data(),
-                                               binFrequencies.data(),
+        juce::FloatVectorOperations::multiply(weightedMagnitudes,
+                                               binFrequencies,
                                                &magnitudes[1],
                                                numBins - 1);
 
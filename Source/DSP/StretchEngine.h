@@ -0,0 +1,304 @@
+//
+// Signalsmith Stretch wrapper with latency alignment and priming
+//
+
+#pragma once
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <signalsmith-stretch/signalsmith-stretch.h>
+#include "../Utility/DspArena.h"
+
+/**
+ * One pitch/formant shifting engine.
+ *
+ * Wraps a SignalsmithStretch configured for a quality preset, remembers the
+ * values last handed to it so setters only run on change, and can delay its
+ * input so engines with different presets report the same latency. That
+ * lets the processor crossfade between engines without the host seeing a
+ * latency change. The delay sits on the input side so prime() can fill it
+ * from history too, and a freshly primed engine needs no warm-up.
+ *
+ * configure(), alignTo(), warmUp() and probe() allocate; everything else
+ * is real-time safe. The delay line and its scratch buffer live in the engine's own
+ * prefaulted arena, so an engine can be rebuilt without touching the
+ * processor's memory.
+ */
+class StretchEngine
+{
+public:
+    enum class Quality
+    {
+        Default,
+        Cheaper
+    };
+
+    /** Latency and seek length a preset will have, without building a full engine. */
+    struct PresetInfo
+    {
+        int latency { 0 };
+        int seekLength { 0 };
+    };
+
+    /** Configures a throwaway single-channel stretch to read off a preset's sizes (allocates). */
+    static PresetInfo probe(double sampleRate, Quality presetQuality)
+    {
+        signalsmith::stretch::SignalsmithStretch<float> probeStretch;
+        applyPreset(probeStretch, 1, sampleRate, presetQuality);
+        return { probeStretch.inputLatency() + probeStretch.outputLatency(), probeStretch.seekLength() };
+    }
+
+    void configure(int channels, double sampleRate, int maxBlockSize, Quality newQuality)
+    {
+        numChannels = channels;
+        maxBlockSamples = juce::jmax(1, maxBlockSize);
+        quality = newQuality;
+
+        applyPreset(stretch, channels, sampleRate, quality);
+
+        setAlignmentDelay(0);
+        reset();
+    }
+
+    /**
+     * Runs silence through the engine so the stretch's lazily touched memory
+     * is faulted in, then resets. Allocates; call off the audio thread.
+     */
+    void warmUp()
+    {
+        juce::AudioBuffer<float> silence(juce::jmax(1, numChannels), maxBlockSamples);
+        juce::AudioBuffer<float> output(juce::jmax(1, numChannels), maxBlockSamples);
+        silence.clear();
+
+        setParameters(0.0f, 0.0f, 0.0f, true, 0.0f);
+        for (int done = 0; done < getPrimeLength(); done += maxBlockSamples)
+            process(silence.getArrayOfReadPointers(), output.getArrayOfWritePointers(), maxBlockSamples);
+
+        reset();
+    }
+
+    Quality getQuality() const { return quality; }
+
+    /** Latency of the stretch itself, without alignment. */
+    int getEngineLatency() const { return stretch.inputLatency() + stretch.outputLatency(); }
+
+    /** Total latency including the alignment delay. */
+    int getLatency() const { return getEngineLatency() + alignmentDelay; }
+
+    /** Delays the input so getLatency() matches targetLatency (which must be >= getEngineLatency()). */
+    void alignTo(int targetLatency) { setAlignmentDelay(juce::jmax(0, targetLatency - getEngineLatency())); }
+
+    /** Input samples needed by prime() to fully warm the engine. */
+    int getPrimeLength() const { return stretch.seekLength() + alignmentDelay; }
+
+    void reset()
+    {
+        stretch.reset();
+        alignment.clear();
+        alignmentPosition = 0;
+
+        // The next setParameters() pushes every value
+        settingsStale = true;
+    }
+
+    /**
+     * Resets the engine and feeds it recent input so its first output is
+     * already steady-state. history holds numSamples in chronological order.
+     */
+    void prime(const juce::AudioBuffer<float>& history, int numSamples)
+    {
+        stretch.reset();
+        alignmentPosition = 0;
+
+        // The newest samples go into the alignment delay (oldest first), the rest into the stretch
+        const int delayed = juce::jmin(alignmentDelay, numSamples);
+        const int seekSamples = numSamples - delayed;
+
+        alignment.clear();
+        for (int ch = 0; ch < juce::jmin(numChannels, history.getNumChannels()); ++ch)
+            alignment.copyFrom(ch, alignmentDelay - delayed, history, ch, seekSamples, delayed);
+
+        if (seekSamples > 0)
+            stretch.seek(history.getArrayOfReadPointers(), seekSamples, 1.0);
+    }
+
+    /** Hands the current shift settings to the stretch, skipping unchanged values. */
+    void setParameters(float pitchSemitones, float tonalityNorm, float formantSemitones,
+                       bool formantCompensation, float formantBaseNorm)
+    {
+        const bool pushAll = settingsStale;
+        settingsStale = false;
+
+        if (pushAll || pitchSemitones != appliedPitchSemitones || tonalityNorm != appliedTonalityNorm)
+        {
+            stretch.setTransposeSemitones(pitchSemitones, tonalityNorm);
+            appliedPitchSemitones = pitchSemitones;
+            appliedTonalityNorm = tonalityNorm;
+        }
+
+        if (pushAll || formantSemitones != appliedFormantSemitones || formantCompensation != appliedFormantCompensation)
+        {
+            stretch.setFormantSemitones(formantSemitones, formantCompensation);
+            appliedFormantSemitones = formantSemitones;
+            appliedFormantCompensation = formantCompensation;
+        }
+
+        if (pushAll || formantBaseNorm != appliedFormantBaseNorm)
+        {
+            stretch.setFormantBase(formantBaseNorm);
+            appliedFormantBaseNorm = formantBaseNorm;
+        }
+    }
+
+    /** Processes numSamples (up to the configured maximum) from inputs into outputs. */
+    void process(const float* const* inputs, float* const* outputs, int numSamples)
+    {
+        if (alignmentDelay == 0)
+        {
+            stretch.process(inputs, numSamples, outputs, numSamples);
+            return;
+        }
+
+        // Read the input through the alignment delay: each sample is swapped for the one alignmentDelay ago
+        int position = alignmentPosition;
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            const float* in = inputs[ch];
+            float* delay = alignment.getWritePointer(ch);
+            float* out = delayedInput.getWritePointer(ch);
+            position = alignmentPosition;
+
+            for (int i = 0; i < numSamples; ++i)
+            {
+                out[i] = delay[position];
+                delay[position] = in[i];
+                if (++position == alignmentDelay)
+                    position = 0;
+            }
+        }
+        alignmentPosition = position;
+
+        stretch.process(delayedInput.getArrayOfReadPointers(), numSamples, outputs, numSamples);
+    }
+
+private:
+    signalsmith::stretch::SignalsmithStretch<float> stretch;
+    Quality quality { Quality::Default };
+    int numChannels { 0 };
+
+    DspArena arena;
+    juce::AudioBuffer<float> alignment;     // Arena-backed
+    juce::AudioBuffer<float> delayedInput;  // Arena-backed
+    int maxBlockSamples { 1 };
+    int alignmentDelay { 0 };
+    int alignmentPosition { 0 };
+
+    // Values last handed to the stretch, so setters only run on change. Only compared once
+    // settingsStale is clear, so a fresh or reset engine gets everything, including values
+    // equal to the parameter defaults (an explicit flag, since fast-math can fold NaN checks)
+    bool settingsStale { true };
+    float appliedPitchSemitones { 0.0f };
+    float appliedTonalityNorm { 0.0f };
+    float appliedFormantSemitones { 0.0f };
+    bool appliedFormantCompensation { true };
+    float appliedFormantBaseNorm { 0.0f };
+
+    static void applyPreset(signalsmith::stretch::SignalsmithStretch<float>& target, int channels,
+                            double sampleRate, Quality presetQuality)
+    {
+        if (presetQuality == Quality::Cheaper)
+            target.presetCheaper(channels, static_cast<float>(sampleRate), true);
+        else
+            target.presetDefault(channels, static_cast<float>(sampleRate), true);
+    }
+
+    void setAlignmentDelay(int samples)
+    {
+        alignmentDelay = samples;
+
+        const int channels = juce::jmax(1, numChannels);
+        const int delaySamples = juce::jmax(1, samples);
+        arena.prepare(DspArena::bytesForBuffer(channels, delaySamples)
+                          + DspArena::bytesForBuffer(channels, maxBlockSamples),
+                      true);
+        arena.allocateBuffer(alignment, channels, delaySamples);
+        arena.allocateBuffer(delayedInput, channels, maxBlockSamples);
+        alignmentPosition = 0;
+    }
+};
+
+/**
+ * Ring of the most recent input, used to prime an engine before it is
+ * crossfaded in. Real-time safe after prepare().
+ */
+class StretchHistory
+{
+public:
+    /** Arena space needed by prepare(). */
+    static size_t getArenaBytes(int channels, int length)
+    {
+        return DspArena::bytesForBuffer(channels, juce::jmax(1, length)) * 2;
+    }
+
+    void prepare(int channels, int length, DspArena& arena)
+    {
+        arena.allocateBuffer(ring, channels, juce::jmax(1, length));
+        arena.allocateBuffer(linear, channels, juce::jmax(1, length));
+        reset();
+    }
+
+    void reset()
+    {
+        ring.clear();
+        writePosition = 0;
+    }
+
+    int getLength() const { return ring.getNumSamples(); }
+
+    void push(const juce::AudioBuffer<float>& buffer, int numSamples)
+    {
+        const int length = ring.getNumSamples();
+        const int channels = juce::jmin(ring.getNumChannels(), buffer.getNumChannels());
+
+        // Only the newest `length` samples matter
+        const int skip = juce::jmax(0, numSamples - length);
+        int position = writePosition;
+
+        for (int ch = 0; ch < channels; ++ch)
+        {
+            position = writePosition;
+            int remaining = numSamples - skip;
+            int source = skip;
+
+            while (remaining > 0)
+            {
+                const int chunk = juce::jmin(remaining, length - position);
+                ring.copyFrom(ch, position, buffer, ch, source, chunk);
+                position = (position + chunk) % length;
+                source += chunk;
+                remaining -= chunk;
+            }
+        }
+        writePosition = position;
+    }
+
+    /** Returns the last numSamples of input in chronological order (numSamples <= getLength()). */
+    const juce::AudioBuffer<float>& getLinear(int numSamples)
+    {
+        const int length = ring.getNumSamples();
+        numSamples = juce::jmin(numSamples, length);
+        const int start = (writePosition - numSamples + length) % length;
+        const int first = juce::jmin(numSamples, length - start);
+
+        for (int ch = 0; ch < ring.getNumChannels(); ++ch)
+        {
+            linear.copyFrom(ch, 0, ring, ch, start, first);
+            if (numSamples > first)
+                linear.copyFrom(ch, first, ring, ch, 0, numSamples - first);
+        }
+        return linear;
+    }
+
+private:
+    juce::AudioBuffer<float> ring;    // Arena-backed
+    juce::AudioBuffer<float> linear;  // Arena-backed
+    int writePosition { 0 };
+};
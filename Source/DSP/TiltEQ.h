@@ -5,6 +5,7 @@
 
 #pragma once
 #include <juce_dsp/juce_dsp.h>
+#include <vector>
 
 /**
  * Shelving tilt EQ filter with adjustable center frequency and gain.
@@ -17,9 +18,24 @@
  * the frequency response (when viewed on a log scale).
  *
  * Features:
- * - Smooth parameter changes with 50ms ramp time on center frequency
+ * - Smooth parameter changes with 50ms ramp time on center frequency and gain
  * - Q factor: 0.4 (fixed)
  * - Gain range: typically -6 dB to +6 dB
+ * - Channels packed into SIMD lanes (stereo runs as one vector)
+ * - Topology-preserving (trapezoidal) state-variable shelves, so coefficients
+ *   can change every 16 samples without zipper noise or allocation
+ *
+ * Because the two shelves have reciprocal gains, they share the same warped
+ * cutoff and therefore the same SVF coefficients. The high shelf is then the
+ * low shelf scaled by A^2, so the cascade is merged into one structure: the
+ * input is pre-multiplied by A^2 and run twice through the same low-shelf
+ * section, in one pass over the buffer with a single coefficient set.
+ *
+ * The tilt runs in the time domain after the stretch. SignalsmithStretch's
+ * public spectral controls are setFreqMap (remaps bin frequencies only) and
+ * setFormantFactor/setFormantSemitones/setFormantBase (shift the formant
+ * envelope); its per-bin spectrum is private, so a per-bin tilt curve can't
+ * be applied before resynthesis without forking the library.
  *
  * Adapted from https://github.com/jcurtis4207/Juce-Plugins
  */
@@ -29,19 +45,25 @@ public:
     void prepare (const juce::dsp::ProcessSpec& spec)
     {
         sampleRate = spec.sampleRate;
-        filterChain.prepare (spec);
-        filterChain.reset();
+        numChannels = static_cast<int> (spec.numChannels);
+
+        const int numGroups = (numChannels + lanes - 1) / lanes;
+        state.resize (static_cast<size_t> (numGroups));
+        reset();
 
-        // Initialize smoothed value with 50ms ramp time
+        // Initialize smoothed values with 50ms ramp time
         smoothedCentreFreq.reset(sampleRate, 0.05);
         smoothedCentreFreq.setCurrentAndTargetValue(centreFreq);
+        smoothedGainDb.reset(sampleRate, 0.05);
+        smoothedGainDb.setCurrentAndTargetValue(gainDb);
 
-        updateCoefficients();
+        updateCoefficients(centreFreq, gainDb);
     }
 
     void reset()
     {
-        filterChain.reset();
+        for (auto& group : state)
+            group = {};
     }
 
     void setCentreFrequency (float newFreq)
@@ -53,7 +75,6 @@ public:
         {
             centreFreq = newFreq;
             smoothedCentreFreq.setTargetValue(newFreq);
-            needsUpdate = true;
         }
     }
 
@@ -62,59 +83,152 @@ public:
         if (gainDb != newGainDb)
         {
             gainDb = newGainDb;
-            needsUpdate = true;
+            smoothedGainDb.setTargetValue(newGainDb);
         }
     }
 
     void process (juce::AudioBuffer<float>& buffer)
     {
-        // Update coefficients if needed (once per block is fine for tilt EQ)
-        if (needsUpdate || smoothedCentreFreq.isSmoothing())
+        const int channels = juce::jmin (numChannels, buffer.getNumChannels());
+        const int numSamples = buffer.getNumSamples();
+
+        for (int start = 0; start < numSamples; start += updateInterval)
         {
-            float targetFreq = smoothedCentreFreq.getNextValue();
-            updateCoefficientsWithFreq(targetFreq);
+            const int chunk = juce::jmin (updateInterval, numSamples - start);
 
-            if (!smoothedCentreFreq.isSmoothing())
-                needsUpdate = false;
-        }
+            // Coefficients follow the smoothers every updateInterval samples
+            if (smoothedCentreFreq.isSmoothing() || smoothedGainDb.isSmoothing())
+                updateCoefficients (smoothedCentreFreq.skip (chunk), smoothedGainDb.skip (chunk));
 
-        juce::dsp::AudioBlock<float> block (buffer);
-        juce::dsp::ProcessContextReplacing<float> context (block);
-        filterChain.process (context);
+            for (int firstChannel = 0, group = 0; firstChannel < channels; firstChannel += lanes, ++group)
+                processGroup (buffer, firstChannel, juce::jmin (lanes, channels - firstChannel), start, chunk,
+                              state[static_cast<size_t> (group)]);
+        }
     }
 
 private:
-    using Filter = juce::dsp::IIR::Filter<float>;
-    using Coeffs = juce::dsp::IIR::Coefficients<float>;
-    using StereoFilter = juce::dsp::ProcessorDuplicator<Filter, Coeffs>;
+   #if JUCE_USE_SIMD
+    using Vec = juce::dsp::SIMDRegister<float>;
+    static constexpr int lanes = static_cast<int> (Vec::SIMDNumElements);
+    static constexpr size_t vecAlignment = Vec::SIMDRegisterSize;
+   #else
+    using Vec = float;
+    static constexpr int lanes = 1;
+    static constexpr size_t vecAlignment = alignof (float);
+   #endif
+
+    static constexpr int updateInterval = 16;
+    static constexpr float q = 0.4f;
+
+    /** SVF integrator coefficients, low-shelf output mix and the pre-multiplied gain. */
+    struct Coefficients
+    {
+        float a1 = 1.0f, a2 = 0.0f, a3 = 0.0f;
+        float m1 = 0.0f, m2 = 0.0f;
+        float gain = 1.0f;
+    };
+
+    /** Integrator states for both sections of one lane group. */
+    struct alignas (vecAlignment) GroupState
+    {
+        Vec first1 {}, first2 {}, second1 {}, second2 {};
+    };
 
-    juce::dsp::ProcessorChain<StereoFilter, StereoFilter> filterChain;
+    std::vector<GroupState> state;
+    Coefficients coeffs;
 
     double sampleRate = 44100.0;
+    int numChannels   = 2;
     float centreFreq  = 1000.0f;
     float gainDb      = 0.0f;
 
-    bool needsUpdate = true;
+    juce::SmoothedValue<float, juce::ValueSmoothingTypes::Multiplicative> smoothedCentreFreq;
+    juce::SmoothedValue<float> smoothedGainDb;
 
-    juce::SmoothedValue<float> smoothedCentreFreq;
+    static Vec broadcast (float value)
+    {
+       #if JUCE_USE_SIMD
+        return Vec::expand (value);
+       #else
+        return value;
+       #endif
+    }
 
-    void updateCoefficientsWithFreq(float freq)
+    void processGroup (juce::AudioBuffer<float>& buffer, int firstChannel, int groupChannels,
+                       int startSample, int numSamples, GroupState& s) const
     {
-        const float q = 0.4f;
+        const Vec a1 = broadcast (coeffs.a1), a2 = broadcast (coeffs.a2), a3 = broadcast (coeffs.a3);
+        const Vec m1 = broadcast (coeffs.m1), m2 = broadcast (coeffs.m2);
+        const Vec gain = broadcast (coeffs.gain);
+        const Vec two = broadcast (2.0f);
 
-        auto lowGain  = juce::Decibels::decibelsToGain (-gainDb);
-        auto highGain = juce::Decibels::decibelsToGain ( gainDb);
+        float* channelData[lanes] {};
+        for (int lane = 0; lane < groupChannels; ++lane)
+            channelData[lane] = buffer.getWritePointer (firstChannel + lane, startSample);
 
-        *filterChain.get<0>().state =
-            *Coeffs::makeLowShelf (sampleRate, freq, q, lowGain);
+        Vec first1 = s.first1, first2 = s.first2, second1 = s.second1, second2 = s.second2;
+        alignas (vecAlignment) float frame[lanes] {};
 
-        *filterChain.get<1>().state =
-            *Coeffs::makeHighShelf (sampleRate, freq, q, highGain);
+        // One low-shelf section (m0 = 1); both passes use the same coefficients
+        const auto section = [&] (Vec in, Vec& ic1, Vec& ic2)
+        {
+            const Vec v3 = in - ic2;
+            const Vec v1 = a1 * ic1 + a2 * v3;
+            const Vec v2 = ic2 + a2 * ic1 + a3 * v3;
+            ic1 = two * v1 - ic1;
+            ic2 = two * v2 - ic2;
+            return in + m1 * v1 + m2 * v2;
+        };
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            for (int lane = 0; lane < groupChannels; ++lane)
+                frame[lane] = channelData[lane][i];
+
+           #if JUCE_USE_SIMD
+            const Vec x = Vec::fromRawArray (frame);
+           #else
+            const Vec x = frame[0];
+           #endif
+
+            const Vec y = section (section (gain * x, first1, first2), second1, second2);
+
+           #if JUCE_USE_SIMD
+            y.copyToRawArray (frame);
+           #else
+            frame[0] = y;
+           #endif
+
+            for (int lane = 0; lane < groupChannels; ++lane)
+                channelData[lane][i] = frame[lane];
+        }
+
+        s.first1 = first1;
+        s.first2 = first2;
+        s.second1 = second1;
+        s.second2 = second2;
     }
 
-    void updateCoefficients()
+    // Trapezoidal SVF shelves (A = 10^(dB/40), shelf gain = A^2).
+    // highShelf(A) = A^2 * lowShelf(1/A) at the same g, hence the merged form.
+    void updateCoefficients (float freq, float dB)
     {
-        updateCoefficientsWithFreq(centreFreq);
-        needsUpdate = false;
+        const float nyquistSafeFreq = juce::jmin (freq, static_cast<float> (sampleRate * 0.49));
+        const float warped = std::tan (juce::MathConstants<float>::pi * nyquistSafeFreq / static_cast<float> (sampleRate));
+
+        const float highA = std::pow (10.0f, dB / 40.0f);
+        const float lowA  = 1.0f / highA;
+        const float k = 1.0f / q;
+
+        // Low shelf uses g / sqrt(lowA), high shelf g * sqrt(highA): identical for a tilt
+        const float g = warped * std::sqrt (highA);
+
+        coeffs.a1 = 1.0f / (1.0f + g * (g + k));
+        coeffs.a2 = g * coeffs.a1;
+        coeffs.a3 = g * coeffs.a2;
+
+        coeffs.m1 = k * (lowA - 1.0f);
+        coeffs.m2 = lowA * lowA - 1.0f;
+        coeffs.gain = highA * highA;
     }
 };
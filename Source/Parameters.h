@@ -0,0 +1,63 @@
+//
+// Shared parameter table
+//
+
+#pragma once
+#include <array>
+#include <cstdint>
+
+/**
+ * Compile-time table of every plugin parameter.
+ *
+ * The enum order is the canonical parameter order: createParameters(),
+ * the processor's cached parameter pointers and PresetManager all index
+ * through it, so string IDs are only ever spelled out here.
+ */
+enum class Param : int
+{
+    PitchSemitones,
+    PitchCents,
+    FormantSemitones,
+    FormantCents,
+    FormantCompensation,
+    TonalityHz,
+    FormantBaseHz,
+    FormantBaseAuto,
+    TiltGainDb,
+    TiltCentreHz,
+    TiltCentreAuto,
+    NumParams
+};
+
+inline constexpr int numParams = static_cast<int>(Param::NumParams);
+
+inline constexpr std::array<const char*, numParams> paramIDs {
+    "PITCH_SEMITONES",
+    "PITCH_CENTS",
+    "FORMANT_SEMITONES",
+    "FORMANT_CENTS",
+    "FORMANT_COMPENSATION",
+    "TONALITY_HZ",
+    "FORMANT_BASE_HZ",
+    "FORMANT_BASE_AUTO",
+    "TILT_GAIN_DB",
+    "TILT_CENTRE_HZ",
+    "TILT_CENTRE_AUTO"
+};
+
+/** Returns the APVTS parameter ID string for a parameter. */
+constexpr const char* toID(Param p)
+{
+    return paramIDs[static_cast<size_t>(p)];
+}
+
+/** Returns the dirty-mask bit for a parameter. */
+constexpr uint32_t paramBit(Param p)
+{
+    return 1u << static_cast<int>(p);
+}
+
+static_assert(numParams <= 32, "Dirty mask is a uint32_t");
+
+/** Mask with the bit of every parameter set. */
+inline constexpr uint32_t allParamBits = numParams == 32 ? ~0u : (1u << numParams) - 1u;
@@ -5,7 +5,43 @@
 SpectralShiftAudioProcessorEditor::SpectralShiftAudioProcessorEditor (SpectralShiftAudioProcessor& p)
     : AudioProcessorEditor (&p), audioProcessor (p)
 {
-    setLookAndFeel(&customLookAndFeel);
+    // One look-and-feel for every open editor in the process
+    setLookAndFeel(&customLookAndFeel.get());
+
+    // Hosts size their window from this straight away; the controls are built when it is first shown
+    setSize(400, 650);
+}
+
+SpectralShiftAudioProcessorEditor::~SpectralShiftAudioProcessorEditor()
+{
+    vBlankAttachment.reset();
+    setLookAndFeel(nullptr);
+
+    if (controlsCreated)
+    {
+        xyPad.deregisterSlider(pitchSemitonesSlider.get());
+        xyPad.deregisterSlider(formantSemitonesSlider.get());
+    }
+}
+
+void SpectralShiftAudioProcessorEditor::visibilityChanged()
+{
+    if (isShowing())
+        createControls();
+}
+
+void SpectralShiftAudioProcessorEditor::parentHierarchyChanged()
+{
+    if (isShowing())
+        createControls();
+}
+
+void SpectralShiftAudioProcessorEditor::createControls()
+{
+    if (controlsCreated)
+        return;
+
+    controlsCreated = true;
 
     // ========== XY Pad Setup ==========
     addAndMakeVisible(xyPad);
@@ -25,7 +61,7 @@ SpectralShiftAudioProcessorEditor::SpectralShiftAudioProcessorEditor (SpectralSh
     pitchSemitonesSlider = std::make_unique<juce::Slider>(juce::Slider::RotaryVerticalDrag, juce::Slider::NoTextBox);
     pitchSemitonesSlider->setRange(-semitonesRange, semitonesRange, 0.01);
     addAndMakeVisible(*pitchSemitonesSlider);
-    pitchSemitonesAttachment = std::make_unique<Attachment>(audioProcessor.apvts, "PITCH_SEMITONES", *pitchSemitonesSlider);
+    pitchSemitonesAttachment = std::make_unique<Attachment>(audioProcessor.apvts, toID(Param::PitchSemitones), *pitchSemitonesSlider);
 
     // Pitch label
     pitchStaticLabel = std::make_unique<juce::Label>("", "PITCH");
@@ -35,7 +71,7 @@ SpectralShiftAudioProcessorEditor::SpectralShiftAudioProcessorEditor (SpectralSh
     addAndMakeVisible(*pitchStaticLabel);
 
     pitchSemitonesLabel = std::make_unique<juce::Label>();
-    pitchSemitonesLabel->setText(juce::String(audioProcessor.apvts.getRawParameterValue("PITCH_SEMITONES")->load(), 1) + " st", juce::dontSendNotification);
+    pitchSemitonesLabel->setText(juce::String(audioProcessor.apvts.getRawParameterValue(toID(Param::PitchSemitones))->load(), 1) + " st", juce::dontSendNotification);
     pitchSemitonesLabel->setJustificationType(juce::Justification::centred);
     pitchSemitonesLabel->setColour(juce::Label::textColourId, CustomLookAndFeel::Colors::textDim);
     pitchSemitonesLabel->setColour(juce::Label::backgroundColourId, CustomLookAndFeel::Colors::transparent);
@@ -45,7 +81,7 @@ SpectralShiftAudioProcessorEditor::SpectralShiftAudioProcessorEditor (SpectralSh
     pitchSemitonesLabel->onTextChange = [this, semitonesRange]() {
         float value = pitchSemitonesLabel->getText().retainCharacters("-0123456789.").getFloatValue();
         value = juce::jlimit(-semitonesRange, semitonesRange, value);
-        if (auto* param = audioProcessor.apvts.getParameter("PITCH_SEMITONES"))
+        if (auto* param = audioProcessor.apvts.getParameter(toID(Param::PitchSemitones)))
             param->setValueNotifyingHost(param->getNormalisableRange().convertTo0to1(value));
     };
     addAndMakeVisible(*pitchSemitonesLabel);
@@ -58,7 +94,7 @@ SpectralShiftAudioProcessorEditor::SpectralShiftAudioProcessorEditor (SpectralSh
     formantSemitonesSlider = std::make_unique<juce::Slider>(juce::Slider::RotaryVerticalDrag, juce::Slider::NoTextBox);
     formantSemitonesSlider->setRange(-semitonesRange, semitonesRange, 0.01);
     addAndMakeVisible(*formantSemitonesSlider);
-    formantSemitonesAttachment = std::make_unique<Attachment>(audioProcessor.apvts, "FORMANT_SEMITONES", *formantSemitonesSlider);
+    formantSemitonesAttachment = std::make_unique<Attachment>(audioProcessor.apvts, toID(Param::FormantSemitones), *formantSemitonesSlider);
 
     // Formant label
     formantStaticLabel = std::make_unique<juce::Label>("", "FORMANT");
@@ -68,7 +104,7 @@ SpectralShiftAudioProcessorEditor::SpectralShiftAudioProcessorEditor (SpectralSh
     addAndMakeVisible(*formantStaticLabel);
 
     formantSemitonesLabel = std::make_unique<juce::Label>();
-    formantSemitonesLabel->setText(juce::String(audioProcessor.apvts.getRawParameterValue("FORMANT_SEMITONES")->load(), 1) + " st", juce::dontSendNotification);
+    formantSemitonesLabel->setText(juce::String(audioProcessor.apvts.getRawParameterValue(toID(Param::FormantSemitones))->load(), 1) + " st", juce::dontSendNotification);
     formantSemitonesLabel->setJustificationType(juce::Justification::centred);
     formantSemitonesLabel->setColour(juce::Label::textColourId, CustomLookAndFeel::Colors::textDim);
     formantSemitonesLabel->setColour(juce::Label::backgroundColourId, CustomLookAndFeel::Colors::transparent);
@@ -78,7 +114,7 @@ SpectralShiftAudioProcessorEditor::SpectralShiftAudioProcessorEditor (SpectralSh
     formantSemitonesLabel->onTextChange = [this, semitonesRange]() {
         float value = formantSemitonesLabel->getText().retainCharacters("-0123456789.").getFloatValue();
         value = juce::jlimit(-semitonesRange, semitonesRange, value);
-        if (auto* param = audioProcessor.apvts.getParameter("FORMANT_SEMITONES"))
+        if (auto* param = audioProcessor.apvts.getParameter(toID(Param::FormantSemitones)))
             param->setValueNotifyingHost(param->getNormalisableRange().convertTo0to1(value));
     };
     addAndMakeVisible(*formantSemitonesLabel);
@@ -98,7 +134,7 @@ SpectralShiftAudioProcessorEditor::SpectralShiftAudioProcessorEditor (SpectralSh
     pitchCentsSlider->setRange(-200.0, 200.0, 1.0);
     pitchCentsSlider->setColour(juce::Slider::trackColourId, CustomLookAndFeel::Colors::pitchPositive);
     addAndMakeVisible(*pitchCentsSlider);
-    pitchCentsAttachment = std::make_unique<Attachment>(audioProcessor.apvts, "PITCH_CENTS", *pitchCentsSlider);
+    pitchCentsAttachment = std::make_unique<Attachment>(audioProcessor.apvts, toID(Param::PitchCents), *pitchCentsSlider);
 
     pitchCentsLabel = std::make_unique<juce::Label>("", "0c");
     pitchCentsLabel->setJustificationType(juce::Justification::centred);
@@ -116,7 +152,7 @@ SpectralShiftAudioProcessorEditor::SpectralShiftAudioProcessorEditor (SpectralSh
     formantCentsSlider->setRange(-200.0, 200.0, 1.0);
     formantCentsSlider->setColour(juce::Slider::trackColourId, CustomLookAndFeel::Colors::formantPositive);
     addAndMakeVisible(*formantCentsSlider);
-    formantCentsAttachment = std::make_unique<Attachment>(audioProcessor.apvts, "FORMANT_CENTS", *formantCentsSlider);
+    formantCentsAttachment = std::make_unique<Attachment>(audioProcessor.apvts, toID(Param::FormantCents), *formantCentsSlider);
 
     formantCentsLabel = std::make_unique<juce::Label>("", "0c");
     formantCentsLabel->setJustificationType(juce::Justification::centred);
@@ -135,7 +171,7 @@ SpectralShiftAudioProcessorEditor::SpectralShiftAudioProcessorEditor (SpectralSh
     tiltGainDbSlider->setSkewFactorFromMidPoint(0.0);
     tiltGainDbSlider->setColour(juce::Slider::trackColourId, CustomLookAndFeel::Colors::accent);
     addAndMakeVisible(*tiltGainDbSlider);
-    tiltGainDbAttachment = std::make_unique<Attachment>(audioProcessor.apvts, "TILT_GAIN_DB", *tiltGainDbSlider);
+    tiltGainDbAttachment = std::make_unique<Attachment>(audioProcessor.apvts, toID(Param::TiltGainDb), *tiltGainDbSlider);
 
     tiltGainLabel = std::make_unique<juce::Label>("", "TILT");
     tiltGainLabel->setJustificationType(juce::Justification::centredLeft);
@@ -157,7 +193,7 @@ SpectralShiftAudioProcessorEditor::SpectralShiftAudioProcessorEditor (SpectralSh
     tiltCentreHzSlider->setName("TonalitySlider");
     tiltCentreHzSlider->setColour(juce::Slider::trackColourId, CustomLookAndFeel::Colors::tilt);
     addAndMakeVisible(*tiltCentreHzSlider);
-    tiltCentreHzAttachment = std::make_unique<Attachment>(audioProcessor.apvts, "TILT_CENTRE_HZ", *tiltCentreHzSlider);  // Range & skew from parameter
+    tiltCentreHzAttachment = std::make_unique<Attachment>(audioProcessor.apvts, toID(Param::TiltCentreHz), *tiltCentreHzSlider);  // Range & skew from parameter
 
     // Labels (similar to other sliders)
     tiltCentreLabel = std::make_unique<juce::Label>("", "TILT CENTRE");
@@ -186,7 +222,7 @@ SpectralShiftAudioProcessorEditor::SpectralShiftAudioProcessorEditor (SpectralSh
     tiltCentreAutoToggle = std::make_unique<juce::ToggleButton>("");
     tiltCentreAutoToggle->setName("Tilt");
     addAndMakeVisible(*tiltCentreAutoToggle);
-    tiltCentreAutoAttachment = std::make_unique<ButtonAttachment>(audioProcessor.apvts, "TILT_CENTRE_AUTO", *tiltCentreAutoToggle);
+    tiltCentreAutoAttachment = std::make_unique<ButtonAttachment>(audioProcessor.apvts, toID(Param::TiltCentreAuto), *tiltCentreAutoToggle);
 
     tiltCentreAutoToggle->onClick = [this]() {
         bool isAuto = tiltCentreAutoToggle->getToggleState();
@@ -201,6 +237,11 @@ SpectralShiftAudioProcessorEditor::SpectralShiftAudioProcessorEditor (SpectralSh
         } else {
             tiltCentreHzSlider->setColour(juce::Slider::trackColourId,
                 CustomLookAndFeel::Colors::tilt);
+
+            // The slider tracked the live centre while in auto; snap it back to the parameter
+            const float manualHz = audioProcessor.apvts.getRawParameterValue(toID(Param::TiltCentreHz))->load();
+            tiltCentreHzSlider->setValue(manualHz, juce::dontSendNotification);
+            tiltCentreValueLabel->setText(juce::String(static_cast<int>(manualHz)) + " Hz", juce::dontSendNotification);
         }
     };
 
@@ -214,7 +255,7 @@ SpectralShiftAudioProcessorEditor::SpectralShiftAudioProcessorEditor (SpectralSh
     tonalityHzSlider->setName("TonalitySlider");
     tonalityHzSlider->setColour(juce::Slider::trackColourId, CustomLookAndFeel::Colors::tonality);
     addAndMakeVisible(*tonalityHzSlider);
-    tonalityHzAttachment = std::make_unique<Attachment>(audioProcessor.apvts, "TONALITY_HZ", *tonalityHzSlider);  // Range & skew from parameter
+    tonalityHzAttachment = std::make_unique<Attachment>(audioProcessor.apvts, toID(Param::TonalityHz), *tonalityHzSlider);  // Range & skew from parameter
 
     tonalityHzLabel = std::make_unique<juce::Label>("", "TONALITY LIMIT");
     tonalityHzLabel->setJustificationType(juce::Justification::centredLeft);
@@ -244,31 +285,45 @@ SpectralShiftAudioProcessorEditor::SpectralShiftAudioProcessorEditor (SpectralSh
     formantCompensationToggle = std::make_unique<juce::ToggleButton>("");
     formantCompensationToggle->setName("Formant");
     addAndMakeVisible(*formantCompensationToggle);
-    formantCompensationAttachment = std::make_unique<ButtonAttachment>(audioProcessor.apvts, "FORMANT_COMPENSATION", *formantCompensationToggle);
+    formantCompensationAttachment = std::make_unique<ButtonAttachment>(audioProcessor.apvts, toID(Param::FormantCompensation), *formantCompensationToggle);
 
     // ========== CPU Load Display ==========
     cpuLoadLabel = std::make_unique<juce::Label>("", "CPU: 0%");
     cpuLoadLabel->setJustificationType(juce::Justification::centredRight);
     cpuLoadLabel->setColour(juce::Label::textColourId, CustomLookAndFeel::Colors::textDim);
     cpuLoadLabel->setFont(juce::FontOptions(9.0f));
+    cpuLoadLabel->addMouseListener(this, false);
     addAndMakeVisible(*cpuLoadLabel);
 
-    // Start timer to update CPU display (30 Hz refresh rate)
-    startTimerHz(30);
+    // Live displays refresh on the display's vblank, so they stop whenever the editor is hidden
+    vBlankAttachment = std::make_unique<juce::VBlankAttachment>(this, [this] { onVBlank(); });
 
-    setSize(400, 650);
+    resized();
 }
 
-SpectralShiftAudioProcessorEditor::~SpectralShiftAudioProcessorEditor()
+//==============================================================================
+void SpectralShiftAudioProcessorEditor::paint(juce::Graphics& g)
 {
-    setLookAndFeel(nullptr);
-    xyPad.deregisterSlider(pitchSemitonesSlider.get());
-    xyPad.deregisterSlider(formantSemitonesSlider.get());
+    // Labels are transparent, so every label update repaints the background behind it;
+    // blit a cached copy instead of redrawing the gradient each time
+    const float scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+    if (!backgroundCache.isValid() || scale != backgroundCacheScale)
+        renderBackground(scale);
+
+    g.drawImageTransformed(backgroundCache, juce::AffineTransform::scale(1.0f / backgroundCacheScale));
 }
 
-//==============================================================================
-void SpectralShiftAudioProcessorEditor::paint(juce::Graphics& g)
+void SpectralShiftAudioProcessorEditor::renderBackground(float scale)
 {
+    backgroundCacheScale = scale;
+    backgroundCache = juce::Image(juce::Image::RGB,
+                                  juce::jmax(1, juce::roundToInt(getWidth() * scale)),
+                                  juce::jmax(1, juce::roundToInt(getHeight() * scale)),
+                                  false);
+
+    juce::Graphics g(backgroundCache);
+    g.addTransform(juce::AffineTransform::scale(scale));
+
     g.fillAll(CustomLookAndFeel::Colors::background);
 
     // Add subtle vignette
@@ -291,6 +346,11 @@ void SpectralShiftAudioProcessorEditor::paint(juce::Graphics& g)
 
 void SpectralShiftAudioProcessorEditor::resized()
 {
+    backgroundCache = {};
+
+    if (!controlsCreated)
+        return;
+
     auto area = getLocalBounds().reduced(20);
     constexpr int padding = 10;
 
@@ -373,23 +433,170 @@ void SpectralShiftAudioProcessorEditor::resized()
     tiltCentreAutoLabel->setBounds(autoToggleArea.removeFromLeft(autoToggleArea.getWidth() - 30));
     tiltCentreAutoToggle->setBounds(autoToggleArea);
 
-    // CPU Load Display (bottom-right corner)
-    cpuLoadLabel->setBounds(getWidth() - 80, getHeight() - 20, 70, 15);
+    // CPU Load Display (bottom-right corner), grows upwards into an overlay when expanded
+    if (hudExpanded)
+    {
+        cpuLoadLabel->setBounds(getWidth() - 230, getHeight() - 100, 220, 95);
+        cpuLoadLabel->toFront(false);
+    }
+    else
+    {
+        cpuLoadLabel->setBounds(getWidth() - 90, getHeight() - 20, 80, 15);
+    }
+}
+
+void SpectralShiftAudioProcessorEditor::mouseUp(const juce::MouseEvent& event)
+{
+    if (event.eventComponent != cpuLoadLabel.get())
+        return;
+
+    if (event.mods.isPopupMenu())
+    {
+        showGovernorMenu();
+        return;
+    }
+
+    hudExpanded = !hudExpanded;
+
+    // Start each expanded session with fresh percentiles
+    if (hudExpanded)
+        audioProcessor.getProfiler().requestReset();
+
+    cpuLoadLabel->setJustificationType(hudExpanded ? juce::Justification::topLeft : juce::Justification::centredRight);
+    cpuLoadLabel->setColour(juce::Label::backgroundColourId,
+                            hudExpanded ? CustomLookAndFeel::Colors::backgroundDark.withAlpha(0.9f)
+                                        : CustomLookAndFeel::Colors::transparent);
+    resized();
+
+    shownCpuPercent = -1;
+    unchangedRefreshes = 0;
+    updateCpuDisplay(audioProcessor.getTelemetry().getLatest());
+}
+
+void SpectralShiftAudioProcessorEditor::showGovernorMenu()
+{
+    const auto& governor = audioProcessor.getGovernor();
+
+    juce::PopupMenu budgetMenu;
+    for (const float budget : { 0.5f, 0.6f, 0.75f, 0.9f })
+        budgetMenu.addItem(juce::String(juce::roundToInt(budget * 100.0f)) + "% of block time", true,
+                           std::abs(governor.getBudget() - budget) < 0.001f,
+                           [this, budget] { audioProcessor.setGovernorBudget(budget); });
+
+    juce::PopupMenu menu;
+    menu.addSectionHeader("CPU governor");
+    menu.addItem("Reduce quality when over budget", true, governor.isEnabled(),
+                 [this, enabled = governor.isEnabled()] { audioProcessor.setGovernorEnabled(!enabled); });
+    menu.addSubMenu("Budget", budgetMenu);
+
+    menu.showMenuAsync(juce::PopupMenu::Options().withTargetComponent(cpuLoadLabel.get()));
 }
 
-void SpectralShiftAudioProcessorEditor::timerCallback()
+void SpectralShiftAudioProcessorEditor::onVBlank()
+{
+    // The vblank rate is the display's; poll telemetry far less often, and less still when idle
+    const double now = juce::Time::getMillisecondCounterHiRes();
+    const double interval = unchangedRefreshes >= idleRefreshesBeforeBackoff ? idleRefreshIntervalMs : refreshIntervalMs;
+    if (now - lastRefreshMs < interval)
+        return;
+
+    lastRefreshMs = now;
+    unchangedRefreshes = refreshDisplays() ? 0 : unchangedRefreshes + 1;
+}
+
+bool SpectralShiftAudioProcessorEditor::refreshDisplays()
+{
+    // Drain queued telemetry; only the newest snapshot is displayed
+    std::array<Telemetry::Snapshot, 16> snapshots;
+    auto& telemetry = audioProcessor.getTelemetry();
+    uint64_t newestFlowId = 0;
+    int popped = 0;
+    do
+    {
+        popped = telemetry.pop(snapshots.data(), static_cast<int>(snapshots.size()));
+        if (popped > 0)
+            newestFlowId = snapshots[static_cast<size_t>(popped - 1)].flowId;
+    } while (popped == static_cast<int>(snapshots.size()));
+    const auto latest = telemetry.getLatest();
+
+    #if PERFETTO
+    // Close the flow from the block whose values are about to be shown
+    if (newestFlowId != 0)
+        TRACE_EVENT("component", "telemetry-drain", perfetto::TerminatingFlow::ProcessScoped(newestFlowId));
+    #else
+    juce::ignoreUnused(newestFlowId);
+    #endif
+
+    bool changed = false;
+
+    // Show the live tilt centre without writing to the host parameter; only whole-Hz changes are visible
+    if (tiltCentreAutoToggle->getToggleState() && latest.tiltCentreHz > 0.0f)
+    {
+        const int tiltCentreHz = static_cast<int>(latest.tiltCentreHz);
+        if (tiltCentreHz != shownTiltCentreHz)
+        {
+            shownTiltCentreHz = tiltCentreHz;
+            tiltCentreHzSlider->setValue(latest.tiltCentreHz, juce::dontSendNotification);
+            tiltCentreValueLabel->setText(juce::String(tiltCentreHz) + " Hz", juce::dontSendNotification);
+            changed = true;
+        }
+    }
+    else
+    {
+        shownTiltCentreHz = -1;
+    }
+
+    return updateCpuDisplay(latest) || changed;
+}
+
+bool SpectralShiftAudioProcessorEditor::updateCpuDisplay(const Telemetry::Snapshot& latest)
 {
     // Update CPU load display
-    double cpuLoad = audioProcessor.getCpuLoad();
+    double cpuLoad = latest.load;
     int cpuPercent = static_cast<int>(cpuLoad * 100.0);
-    cpuLoadLabel->setText("CPU: " + juce::String(cpuPercent) + "%", juce::dontSendNotification);
-
-    // Change color if CPU is high
-    if (cpuLoad > 0.8)  // Over 80%
+    const auto overruns = audioProcessor.getTelemetry().getOverrunCount();
+    const bool reducedQuality = audioProcessor.getGovernor().getTier() != CpuGovernor::Tier::Full;
+
+    // The collapsed label only shows the percentage and the reduced-quality flag
+    if (!hudExpanded && cpuPercent == shownCpuPercent && reducedQuality == shownReducedQuality)
+        return false;
+
+    shownCpuPercent = cpuPercent;
+    shownReducedQuality = reducedQuality;
+    const auto previousText = cpuLoadLabel->getText();
+
+    if (hudExpanded)
+    {
+        const auto block = audioProcessor.getProfiler().getSummary(StageProfiler::Stage::Block);
+        const double latencyMs = latest.sampleRate > 0.0f ? 1000.0 * latest.latencySamples / latest.sampleRate : 0.0;
+
+        juce::String text;
+        text << "CPU: " << cpuPercent << "%   Mode: " << audioProcessor.getQualityModeName() << "\n"
+             << "Block p50 " << juce::String(block.p50Ms, 2)
+             << " / p99 " << juce::String(block.p99Ms, 2)
+             << " / max " << juce::String(block.maxMs, 2) << " ms\n"
+             << "Deadline " << juce::String(latest.deadlineMs, 2) << " ms   Overruns " << static_cast<int>(overruns) << "\n"
+             << "Latency " << latest.latencySamples << " smp (" << juce::String(latencyMs, 1) << " ms)\n"
+             << "Governor " << (audioProcessor.getGovernor().isEnabled() ? "on" : "off")
+             << " (right-click)";
+        cpuLoadLabel->setText(text, juce::dontSendNotification);
+    }
+    else
+    {
+        // Flag reduced quality even when the HUD is collapsed
+        juce::String text = "CPU: " + juce::String(cpuPercent) + "%";
+        if (reducedQuality)
+            text << " *";
+        cpuLoadLabel->setText(text, juce::dontSendNotification);
+    }
+
+    // Change color if CPU is high or a block has missed its deadline
+    if (cpuLoad > 0.8 || (hudExpanded && overruns > 0))  // Over 80%
         cpuLoadLabel->setColour(juce::Label::textColourId, CustomLookAndFeel::Colors::error);
     else if (cpuLoad > 0.5)  // Over 50%
         cpuLoadLabel->setColour(juce::Label::textColourId, CustomLookAndFeel::Colors::accent);
     else
         cpuLoadLabel->setColour(juce::Label::textColourId, CustomLookAndFeel::Colors::textDim);
-}
 
+    return cpuLoadLabel->getText() != previousText;
+}
@@ -14,8 +14,7 @@
 #include "Component/CustomLookAndFeel.h"
 
 //==============================================================================
-class SpectralShiftAudioProcessorEditor  : public juce::AudioProcessorEditor,
-                                            private juce::Timer
+class SpectralShiftAudioProcessorEditor  : public juce::AudioProcessorEditor
 {
 public:
     explicit SpectralShiftAudioProcessorEditor (SpectralShiftAudioProcessor&);
@@ -24,7 +23,16 @@ public:
     //==============================================================================
     void paint (juce::Graphics&) override;
     void resized() override;
-    void timerCallback() override;
+    void mouseUp (const juce::MouseEvent& event) override;
+    void visibilityChanged() override;
+    void parentHierarchyChanged() override;
+
+    /**
+     * Builds the controls and their attachments. Called when the editor is
+     * first shown, so hosts that construct an editor just to query its size
+     * don't pay for them; safe to call more than once.
+     */
+    void createControls();
 
     using Attachment = juce::AudioProcessorValueTreeState::SliderAttachment;
     using ButtonAttachment = juce::AudioProcessorValueTreeState::ButtonAttachment;
@@ -32,7 +40,27 @@ public:
 
 private:
     SpectralShiftAudioProcessor& audioProcessor;
-    CustomLookAndFeel customLookAndFeel;
+    juce::SharedResourcePointer<CustomLookAndFeel> customLookAndFeel;
+    bool controlsCreated = false;
+
+    // Display refresh: runs on the display's vblank, which stops while the editor isn't on screen.
+    // Telemetry is polled at most every refreshIntervalMs, backing off to idleRefreshIntervalMs
+    // once nothing shown has changed for idleRefreshesBeforeBackoff polls
+    std::unique_ptr<juce::VBlankAttachment> vBlankAttachment;
+    double lastRefreshMs = 0.0;
+    int unchangedRefreshes = 0;
+    static constexpr double refreshIntervalMs = 1000.0 / 30.0;
+    static constexpr double idleRefreshIntervalMs = 250.0;
+    static constexpr int idleRefreshesBeforeBackoff = 30;
+
+    /** Drains telemetry and updates the live displays; returns true if anything visible changed. */
+    bool refreshDisplays();
+    void onVBlank();
+
+    // Gradient background, rendered once per size and display scale
+    juce::Image backgroundCache;
+    float backgroundCacheScale = 0.0f;
+    void renderBackground(float scale);
 
     // ========== Main XY Pad Section ==========
     XYPad xyPad;
@@ -84,7 +112,18 @@ private:
     std::unique_ptr<ButtonAttachment> formantCompensationAttachment;
 
     // ========== CPU Load Display ==========
+    // Click to expand into a HUD with block timing percentiles, overruns and latency
     std::unique_ptr<juce::Label> cpuLoadLabel;
+    bool hudExpanded = false;
+    int shownCpuPercent = -1;      // Collapsed label's last inputs, so unchanged values skip the rebuild
+    bool shownReducedQuality = false;
+    int shownTiltCentreHz = -1;
+
+    /** Rebuilds the CPU label / HUD text from the processor's lock-free stats; returns true if it changed. */
+    bool updateCpuDisplay(const Telemetry::Snapshot& latest);
+
+    // Right-click menu on the CPU label for the governor settings
+    void showGovernorMenu();
 
     // Helper method
     void updateBandSelection(int bandIndex);
@@ -23,11 +23,33 @@ SpectralShiftAudioProcessor::SpectralShiftAudioProcessor()
                        ), apvts(*this, nullptr, "Parameters", createParameters())
 #endif
 {
-    apvts.state.addListener(this);
+    for (int i = 0; i < numParams; ++i)
+    {
+        paramValues[static_cast<size_t>(i)] = apvts.getRawParameterValue(paramIDs[static_cast<size_t>(i)]);
+        paramHandles[static_cast<size_t>(i)] = apvts.getParameter(paramIDs[static_cast<size_t>(i)]);
+    }
+
+    presetManager.attach(apvts);
+    presetManager.onPresetListChanged = [this]
+    {
+        updateHostDisplay(ChangeDetails().withProgramChanged(true));
+    };
+
+    auto& ioThread = sharedResources->getIOThread();
+    ioThread.addTimeSliceClient(&watchdog);
+    ioThread.addTimeSliceClient(&sessionRecorder);
+    ioThread.addTimeSliceClient(&engineBuilder);
 }
 
 SpectralShiftAudioProcessor::~SpectralShiftAudioProcessor()
 {
+    cancelPendingUpdate();
+
+    // Waits for any callback in progress, so the clients can be destroyed safely afterwards
+    auto& ioThread = sharedResources->getIOThread();
+    ioThread.removeTimeSliceClient(&engineBuilder);
+    ioThread.removeTimeSliceClient(&sessionRecorder);
+    ioThread.removeTimeSliceClient(&watchdog);
 }
 
 //==============================================================================
@@ -81,7 +103,14 @@ int SpectralShiftAudioProcessor::getCurrentProgram()
 
 void SpectralShiftAudioProcessor::setCurrentProgram (int index)
 {
-    presetManager.applyPreset(index, apvts);
+    if (presetManager.getPresetValues(index) == nullptr)
+        return;
+
+    // Parameters are set here; the audio thread holds off reading them until they all are,
+    // then crossfades to the new preset on a spare engine
+    postCommand({ Command::Type::PresetBegin, index });
+    presetManager.applyPreset(index);
+    postCommand({ Command::Type::PresetApplied, index });
 }
 
 const juce::String SpectralShiftAudioProcessor::getProgramName (int index)
@@ -98,35 +127,59 @@ void SpectralShiftAudioProcessor::changeProgramName (int index, const juce::Stri
 //==============================================================================
 void SpectralShiftAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
 {
-    isActive = true;
+    // Allocates and re-plans only when the configuration actually changed
+    const bool configChanged = prepare(sampleRate, samplesPerBlock);
 
-    const int channels = getTotalNumInputChannels();
-
-    stretch.presetDefault(channels, static_cast<int>(sampleRate), true);
-    stretch.reset();
-
-    stretchBuffer.setSize(channels, samplesPerBlock);
-    inPtrs.resize(channels);
-    outPtrs.resize(channels);
-
-    const int inputLatency  = stretch.inputLatency();
-    const int outputLatency = stretch.outputLatency();
-    setLatencySamples(inputLatency + outputLatency);
+    // A state restored from another thread and not yet applied lands here, before the update below;
+    // off the message thread the async update applies it and the next block picks it up
+    if (juce::MessageManager::existsAndIsCurrentThread())
+        handleUpdateNowIfNeeded();
 
-    juce::dsp::ProcessSpec spec{};
-    spec.sampleRate = sampleRate;
-    spec.maximumBlockSize = samplesPerBlock;
-    spec.numChannels = channels;
-    tiltEQ.prepare(spec);
-    monoBuffer.resize(samplesPerBlock);
-    spectralCentroid.prepare(sampleRate, samplesPerBlock);
+    // Force the next update to push every value into the DSP
+    forceFullUpdate = true;
 
     // Reset CPU load measurer with current sample rate
     loadMeasurer.reset(sampleRate, samplesPerBlock);
 
-    prepare(sampleRate, samplesPerBlock);
+    smoothedPitchSemitones.reset(sampleRate, automationRampSeconds);
+    smoothedFormantSemitones.reset(sampleRate, automationRampSeconds);
+
     update();
-    reset();
+    resetDsp();
+
+    // Start in the tier the governor is already in, without a crossfade
+    governor.reset();
+    const auto tier = governor.getTier();
+    if (activeEngine->getQuality() != getQualityForTier(tier))
+        activeEngine = engineBuilder.build(getQualityForTier(tier));
+    applyQualityTier(tier);
+
+    smoothedPitchSemitones.setCurrentAndTargetValue(currentPitchSemitones);
+    smoothedFormantSemitones.setCurrentAndTargetValue(currentFormantSemitones);
+
+    // A trace only replays correctly for one configuration, so a new one ends it. A
+    // re-prepare with the same settings (transport start, bounce) keeps recording
+    if (configChanged)
+        sessionRecorder.stop();
+
+    const auto traceDirectory = juce::SystemStats::getEnvironmentVariable("SPECTRALSHIFT_SESSION_TRACE", {});
+    if (!sessionRecorder.isRecording() && traceDirectory.isNotEmpty() && juce::File::isAbsolutePath(traceDirectory))
+    {
+        const juce::File directory(traceDirectory);
+        directory.createDirectory();
+
+        const bool includeAudio = juce::SystemStats::getEnvironmentVariable("SPECTRALSHIFT_SESSION_TRACE_AUDIO", "0") == "1";
+        const auto name = "session-" + juce::Time::getCurrentTime().formatted("%Y%m%d-%H%M%S");
+        startSessionRecording(directory.getNonexistentChildFile(name, ".sstrace", false), includeAudio);
+    }
+
+    isActive.store(true, std::memory_order_release);
+}
+
+bool SpectralShiftAudioProcessor::startSessionRecording(const juce::File& file, bool includeAudio)
+{
+    return sessionRecorder.start(file, includeAudio, getSampleRate(),
+                                 getTotalNumInputChannels(), getBlockSize());
 }
 
 
@@ -171,40 +224,196 @@ void SpectralShiftAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer
 
     juce::ignoreUnused(midiMessages);
 
-    if (!isActive)
+    if (!isActive.load(std::memory_order_acquire))
         return;
 
     // Measure CPU load - this scoped timer automatically tracks the processing time
     const juce::AudioProcessLoadMeasurer::ScopedTimer timer(loadMeasurer, buffer.getNumSamples());
 
-    #if PERFETTO
-    TRACE_EVENT_BEGIN("dsp", "parameter-update");
-    #endif
-    update();
-    #if PERFETTO
-    TRACE_EVENT_END("dsp");
-    #endif
+    profiler.beginBlock();
+    const auto blockStart = StageProfiler::Clock::now();
+
+    drainCommands();
+
+    {
+        const StageProfiler::ScopedStage stage(profiler, StageProfiler::Stage::ParameterUpdate);
+
+        #if PERFETTO
+        TRACE_EVENT_BEGIN("dsp", "parameter-update");
+        #endif
+        if (parameterHoldSamples > 0)
+            parameterHoldSamples -= buffer.getNumSamples();
+        else
+            update();
+        #if PERFETTO
+        TRACE_EVENT_END("dsp");
+        #endif
+    }
+
+    // lastParamValues is only refreshed when update() runs, so recordings and the watchdog read the parameters afresh
+    std::array<float, numParams> blockParamValues;
+    for (int i = 0; i < numParams; ++i)
+        blockParamValues[static_cast<size_t>(i)] = paramValues[static_cast<size_t>(i)]->load(std::memory_order_relaxed);
+
+    // Capture the block as the host delivered it, before anything is processed in place
+    sessionRecorder.captureBlock(buffer, buffer.getNumSamples(), blockParamValues);
 
     juce::ScopedNoDenormals noDenormals;
 
-    const int numChannels = buffer.getNumChannels();
+    const int numChannels = juce::jmin(buffer.getNumChannels(), preparedChannels);
     const int numSamples = buffer.getNumSamples();
 
     if (numChannels == 0 || numSamples == 0)
         return;
 
-    stretchBuffer.setSize(numChannels, numSamples, false, false, true);
+    // Pick up an engine the builder finished since the last block
+    swapEngines();
+
+    // Buffers are sized for the prepared block; hosts that exceed it get processed in slices
+    if (numSamples <= maxBlockSamples)
+    {
+        processSlice(buffer, numSamples, numChannels);
+    }
+    else
+    {
+        for (int start = 0; start < numSamples; start += maxBlockSamples)
+        {
+            const int sliceLength = juce::jmin(maxBlockSamples, numSamples - start);
+            juce::AudioBuffer<float> slice(buffer.getArrayOfWritePointers(), numChannels, start, sliceLength);
+            processSlice(slice, sliceLength, numChannels);
+        }
+    }
+
+    // Whole-block time, checked against the block's real-time deadline
+    const auto blockNs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        StageProfiler::Clock::now() - blockStart).count());
+    if (profiler.isEnabled())
+        profiler.record(StageProfiler::Stage::Block, blockNs);
+
+    const double sampleRate = getSampleRate();
+    const float deadlineMs = sampleRate > 0.0 ? static_cast<float>(1000.0 * numSamples / sampleRate) : 0.0f;
+
+    const float load = static_cast<float>(loadMeasurer.getLoadAsProportion());
+
+    #if PERFETTO
+    // Flows link this block to the threads that consume what it publishes
+    const uint64_t telemetryFlowId = Tracing::nextFlowId();
+    const uint64_t watchdogFlowId = Tracing::nextFlowId();
+    #else
+    const uint64_t telemetryFlowId = 0;
+    const uint64_t watchdogFlowId = 0;
+    #endif
+
+    // Capture context for blocks that come close to the deadline
+    const bool captured = watchdog.report(static_cast<float>(blockNs) * 1.0e-6f, deadlineMs, numSamples, sampleRate,
+                                          blockParamValues, profiler, watchdogFlowId);
+
+    // Publish live analysis values for the editor
+    telemetry.publish({ spectralCentroid.getCentroidHz(),
+                        appliedTiltCentreHz,
+                        getLatencySamples(),
+                        load,
+                        static_cast<float>(blockNs) * 1.0e-6f,
+                        deadlineMs,
+                        static_cast<float>(sampleRate),
+                        telemetryFlowId });
+
+    // Step quality down (or back up) against this instance's CPU budget
+    auto previousTier = CpuGovernor::Tier::Full;
+    if (governor.update(load, static_cast<float>(blockNs) * 1.0e-6f, deadlineMs, previousTier))
+    {
+        const auto tier = governor.getTier();
+        watchdog.reportQualityChange(CpuGovernor::getTierName(previousTier), CpuGovernor::getTierName(tier),
+                                     governor.getPressure());
+        applyQualityTier(tier);
+    }
+
+    #if PERFETTO
+    TRACE_COUNTER("dsp", "quality-tier", static_cast<int>(governor.getTier()));
+    TRACE_EVENT_INSTANT("dsp", "telemetry-publish", perfetto::Flow::ProcessScoped(telemetryFlowId));
+    if (captured)
+        TRACE_EVENT_INSTANT("dsp", "watchdog-capture", perfetto::Flow::ProcessScoped(watchdogFlowId));
+
+    TRACE_COUNTER("dsp", "centroid-hz", spectralCentroid.getCentroidHz());
+    TRACE_COUNTER("dsp", "tilt-centre-hz", appliedTiltCentreHz);
+    TRACE_COUNTER("dsp", "block-size", numSamples);
+
+    // Output only carries signal once the input has filled the reported latency; before that
+    // (after a reset) the stretch emits its silent pre-roll
+    const auto latency = static_cast<juce::int64>(getLatencySamples());
+    const auto signalBefore = juce::jmax<juce::int64>(0, stretchInputTotal - latency);
+    stretchInputTotal += numSamples;
+    const auto signalAfter = juce::jmax<juce::int64>(0, stretchInputTotal - latency);
+    TRACE_COUNTER("dsp", "stretch-input-samples", numSamples);
+    TRACE_COUNTER("dsp", "stretch-output-samples", signalAfter - signalBefore);
+
+    TRACE_COUNTER("dsp", "load", load);
+    TRACE_COUNTER("dsp", "telemetry-fifo", telemetry.getNumQueued());
+    TRACE_COUNTER("dsp", "watchdog-fifo", watchdog.getNumQueued());
+    TRACE_COUNTER("dsp", "session-recorder-fifo-bytes", sessionRecorder.getNumQueuedBytes());
+    #else
+    juce::ignoreUnused(captured);
+    #endif
+}
 
-    // Process spectral shift
-    processSpectralShift(buffer, numSamples, numChannels);
+void SpectralShiftAudioProcessor::processSlice(juce::AudioBuffer<float>& buffer, int numSamples, int numChannels)
+{
+    // Track the input fundamental for the formant estimator
+    if (currentFormantBaseAuto && !analysisFrozen)
+    {
+        createMonoSum(buffer, numSamples, numChannels);
+
+        const StageProfiler::ScopedStage stage(profiler, StageProfiler::Stage::PitchTracker);
+
+        #if PERFETTO
+        TRACE_EVENT_BEGIN("dsp", "pitch-tracker");
+        #endif
+
+        pitchTracker.processBlock(monoBuffer, numSamples);
+
+        #if PERFETTO
+        TRACE_EVENT_END("dsp");
+        #endif
+    }
+
+    {
+        const StageProfiler::ScopedStage stage(profiler, StageProfiler::Stage::SignalsmithStretch);
+
+        // Kept so an engine switched in by the governor can be primed with this input
+        inputHistory.push(buffer, numSamples);
+
+        // Process spectral shift in fixed sub-blocks, re-reading the parameters at each one so a
+        // change made mid-block lands within automationQuantum samples and ramps from there
+        for (int start = 0; start < numSamples; start += automationQuantum)
+        {
+            if (start > 0 && parameterHoldSamples <= 0)
+                update();
+
+            smoothedPitchSemitones.setTargetValue(currentPitchSemitones);
+            smoothedFormantSemitones.setTargetValue(currentFormantSemitones);
+
+            processSpectralShift(buffer, start, std::min(automationQuantum, numSamples - start), numChannels);
+        }
+    }
+
+    copyStretchOutput(buffer, numSamples, numChannels);
 
     // Create mono sum for spectral centroid analysis
-    createMonoSum(buffer, numSamples, numChannels);
+    if (currentTiltCentreAuto && !analysisFrozen)
+        createMonoSum(buffer, numSamples, numChannels);
 
     // Calculate and apply tilt EQ
     calculateAndApplyTiltEQ(buffer, numSamples, numChannels);
 }
 
+#if PERFETTO
+bool SpectralShiftAudioProcessor::writePerfettoTrace(const juce::File& destination)
+{
+    const auto written = perfettoSession.endSession();
+    return written.existsAsFile() && written.moveFileTo(destination);
+}
+#endif
+
 
 //==============================================================================
 bool SpectralShiftAudioProcessor::hasEditor() const
@@ -220,105 +429,396 @@ juce::AudioProcessorEditor* SpectralShiftAudioProcessor::createEditor()
 //==============================================================================
 void SpectralShiftAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
 {
-    // You should use this method to store your parameters in the memory block.
-    // You could do that either as raw data, or use the XML or ValueTree classes
-    // as intermediaries to make it easy to save and load complex data.
+    // Plain values straight from the parameter atomics; no ValueTree copy or XML
+    PluginState::State state;
+    for (int i = 0; i < numParams; ++i)
+        state.values[static_cast<size_t>(i)] = paramValues[static_cast<size_t>(i)]->load(std::memory_order_relaxed);
 
-    // Create a temporary ValueTree object called copyState and assign it the value returned by apvts.copyState();
-    juce::ValueTree copyState = apvts.copyState();
+    state.present = allParamBits;
+    state.governorEnabled = governor.isEnabled();
+    state.governorBudget = governor.getBudget();
 
-    // Create a unique_ptr to copy XML information
-    std::unique_ptr<juce::XmlElement> xml = copyState.createXml();
+    {
+        // A restored state the message thread hasn't applied yet is still the current one;
+        // values it doesn't hold keep the current parameter values, as applying it would
+        const juce::SpinLock::ScopedLockType lock(pendingStateLock);
+        if (statePending)
+        {
+            for (int i = 0; i < numParams; ++i)
+                if ((pendingState.present & paramBit(static_cast<Param>(i))) != 0)
+                    state.values[static_cast<size_t>(i)] = pendingState.values[static_cast<size_t>(i)];
+
+            state.governorEnabled = pendingState.governorEnabled;
+            state.governorBudget = pendingState.governorBudget;
+        }
+    }
 
-    // Copy XML that we just created to our binary (Our Memory block)
-    copyXmlToBinary(*xml.get(), destData);
+    PluginState::write(state, destData);
 }
 
 void SpectralShiftAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
 {
-    // You should use this method to restore your parameters from this memory block,
-    // whose contents will have been created by the getStateInformation() call.
+    // Sessions saved before the binary format hold the APVTS state as XML
+    PluginState::State state;
+    if (!PluginState::read(data, sizeInBytes, state) && !readLegacyState(data, sizeInBytes, state))
+        return;
 
-    // Create an xml pointer, and get the XML from the binary (our memory block)
-    std::unique_ptr<juce::XmlElement> xml = getXmlFromBinary(data, sizeInBytes);
+    {
+        const juce::SpinLock::ScopedLockType lock(pendingStateLock);
+        pendingState = state;
+        statePending = true;
+        ++pendingStateSerial;
+    }
 
-    // Create a temporary ValueTree called copyState and save that data into our ValueTree object
-    juce::ValueTree copyState = juce::ValueTree::fromXml(*xml.get());
+    // Parameters are only set from the message thread; restores from elsewhere are coalesced
+    // and applied there. The DSP rebuilds what changed once, at its next update()
+    if (juce::MessageManager::existsAndIsCurrentThread())
+    {
+        cancelPendingUpdate();
+        applyPendingState();
+    }
+    else
+    {
+        triggerAsyncUpdate();
+    }
+}
 
-    // Now we will replace the state with our copyState object in our apvts object
-    apvts.replaceState(copyState);
+bool SpectralShiftAudioProcessor::readLegacyState(const void* data, int sizeInBytes, PluginState::State& state) const
+{
+    const auto xml = getXmlFromBinary(data, sizeInBytes);
+
+    // Malformed or foreign data leaves the current state alone
+    if (xml == nullptr || !xml->hasTagName(apvts.state.getType()))
+        return false;
+
+    state.present = 0;
+
+    // The APVTS stores plain (denormalised) values
+    for (auto* param : xml->getChildWithTagNameIterator("PARAM"))
+    {
+        const auto id = param->getStringAttribute("id");
+        for (int i = 0; i < numParams; ++i)
+        {
+            if (id == paramIDs[static_cast<size_t>(i)])
+            {
+                state.values[static_cast<size_t>(i)] = static_cast<float>(param->getDoubleAttribute("value"));
+                state.present |= paramBit(static_cast<Param>(i));
+            }
+        }
+    }
+
+    state.governorEnabled = xml->getBoolAttribute(governorEnabledID, false);
+    state.governorBudget = static_cast<float>(xml->getDoubleAttribute(governorBudgetID, governor.getBudget()));
+    return true;
 }
 
-void SpectralShiftAudioProcessor::prepare(double sampleRate, int samplesPerBlock)
+void SpectralShiftAudioProcessor::applyPendingState()
 {
+    PluginState::State state;
+    juce::uint32 serial = 0;
+
+    {
+        const juce::SpinLock::ScopedLockType lock(pendingStateLock);
+        if (!statePending)
+            return;
+
+        state = pendingState;
+        serial = pendingStateSerial;
+    }
+
+    for (int i = 0; i < numParams; ++i)
+    {
+        const auto p = static_cast<size_t>(i);
+        if (paramHandles[p] != nullptr && (state.present & paramBit(static_cast<Param>(i))) != 0)
+            paramHandles[p]->setValueNotifyingHost(paramHandles[p]->convertTo0to1(state.values[p]));
+    }
+
+    setGovernorEnabled(state.governorEnabled);
+    setGovernorBudget(state.governorBudget);
+
+    {
+        // Cleared last, so getStateInformation keeps returning the staged state until the
+        // parameters hold it; a newer restore staged meanwhile stays pending for its own update
+        const juce::SpinLock::ScopedLockType lock(pendingStateLock);
+        if (pendingStateSerial == serial)
+            statePending = false;
+    }
+}
+
+bool SpectralShiftAudioProcessor::prepare(double sampleRate, int samplesPerBlock)
+{
+    const int channels = getTotalNumInputChannels();
+    const PreparedConfig config { sampleRate, juce::jmax(1, samplesPerBlock), channels };
+
+    // Hosts re-prepare on every transport start and bounce; the same configuration keeps
+    // the engines, FFT plans and arena, and prepareToPlay only resets state
+    if (config == preparedConfig)
+        return false;
+
+    preparedConfig = config;
+    preparedChannels = channels;
+    maxBlockSamples = config.maxBlockSize;
+
+    // Every engine reports the largest preset latency so swapping engines never changes it
+    const auto defaultPreset = StretchEngine::probe(sampleRate, StretchEngine::Quality::Default);
+    const auto cheaperPreset = StretchEngine::probe(sampleRate, StretchEngine::Quality::Cheaper);
+    const int engineLatency = juce::jmax(defaultPreset.latency, cheaperPreset.latency);
+
+    // Long enough to prime either preset, including its alignment delay
+    const int historyLength = juce::jmax(defaultPreset.seekLength + engineLatency - defaultPreset.latency,
+                                         cheaperPreset.seekLength + engineLatency - cheaperPreset.latency);
+
+    // Later engines are built in the background; the first one is built (and warmed up) here
+    engineBuilder.prepare(channels, sampleRate, automationQuantum, engineLatency);
+    activeEngine = engineBuilder.build(getQualityForTier(governor.getTier()));
+    fadingEngine.reset();
+    spareEngine.reset();
+    spareRequested = false;
+    crossfadeRemaining = 0;
+
+    // Size the arena for everything below, then prefault and lock it in one go
+    const auto pointerBytes = DspArena::bytesFor<float*>(static_cast<size_t>(channels));
+    arena.prepare(DspArena::bytesForBuffer(channels, maxBlockSamples)            // stretchBuffer
+                      + DspArena::bytesForBuffer(channels, automationQuantum)    // crossfadeBuffer
+                      + DspArena::bytesFor<float>(static_cast<size_t>(maxBlockSamples))  // monoBuffer
+                      + pointerBytes * 3
+                      + StretchHistory::getArenaBytes(channels, historyLength)
+                      + SpectralCentroid::getArenaBytes()
+                      + PitchTracker::getArenaBytes(sampleRate),
+                  true);
+
+    inputHistory.prepare(channels, historyLength, arena);
+    engineCrossfadeSamples = juce::jmax(1, static_cast<int>(sampleRate * engineCrossfadeSeconds));
+    presetCrossfadeSamples = juce::jmax(1, static_cast<int>(sampleRate * presetCrossfadeSeconds));
+    arena.allocateBuffer(crossfadeBuffer, channels, automationQuantum);
+
+    arena.allocateBuffer(stretchBuffer, channels, maxBlockSamples);
+    inPtrs = arena.allocate<const float*>(static_cast<size_t>(channels));
+    outPtrs = arena.allocate<float*>(static_cast<size_t>(channels));
+    fadePtrs = arena.allocate<float*>(static_cast<size_t>(channels));
+
+    setLatencySamples(engineLatency);
+
+    juce::dsp::ProcessSpec spec{};
+    spec.sampleRate = sampleRate;
+    spec.maximumBlockSize = static_cast<juce::uint32>(maxBlockSamples);
+    spec.numChannels = static_cast<juce::uint32>(channels);
+    tiltEQ.prepare(spec);
+    monoBuffer = arena.allocate<float>(static_cast<size_t>(maxBlockSamples));
+    spectralCentroid.prepare(sampleRate, maxBlockSamples, arena);
+    pitchTracker.prepare(sampleRate, maxBlockSamples, arena);
+
+    warmUp();
+    return true;
 }
 
 void SpectralShiftAudioProcessor::update()
 {
-    mustUpdateProcessing = false;
-    auto* pitchSemiParam   = apvts.getRawParameterValue("PITCH_SEMITONES");
-    auto* pitchCentsParam  = apvts.getRawParameterValue("PITCH_CENTS");
-    auto* formSemiParam    = apvts.getRawParameterValue("FORMANT_SEMITONES");
-    auto* formCentsParam   = apvts.getRawParameterValue("FORMANT_CENTS");
-    auto* formCompParam    = apvts.getRawParameterValue("FORMANT_COMPENSATION");
-    auto* tonalityHzParam  = apvts.getRawParameterValue("TONALITY_HZ");
-    auto* formantBaseParam = apvts.getRawParameterValue("FORMANT_BASE_HZ");
+    // An explicit flag rather than NaN sentinels: with fast-math, value != NaN may fold to false
+    uint32_t dirty = forceFullUpdate ? ~0u : 0u;
+    forceFullUpdate = false;
 
-    auto* tiltGainDBParam = apvts.getRawParameterValue("TILT_GAIN_DB");
+    for (int i = 0; i < numParams; ++i)
+    {
+        const auto index = static_cast<size_t>(i);
+        const float value = paramValues[index]->load(std::memory_order_relaxed);
+        if (value != lastParamValues[index])
+            dirty |= 1u << i;
+        lastParamValues[index] = value;
+    }
 
+    if (dirty == 0)
+        return;
 
-    const float pitchSemi  = pitchSemiParam->load();
-    const float pitchCents = pitchCentsParam->load();
-    const float formSemi   = formSemiParam->load();
-    const float formCents  = formCentsParam->load();
+    if (dirty & (paramBit(Param::PitchSemitones) | paramBit(Param::PitchCents)))
+        currentPitchSemitones = getParamValue(Param::PitchSemitones) + getParamValue(Param::PitchCents) / 100.0f;
 
-    currentPitchSemitones   = pitchSemi + pitchCents / 100.0f;
-    currentFormantSemitones = formSemi  + formCents  / 100.0f;
+    if (dirty & (paramBit(Param::FormantSemitones) | paramBit(Param::FormantCents)))
+        currentFormantSemitones = getParamValue(Param::FormantSemitones) + getParamValue(Param::FormantCents) / 100.0f;
 
-    currentFormantPreservation = (formCompParam->load() >= 0.5f);
-    currentTonalityHz          = tonalityHzParam->load();
-    currentFormantBaseHz       = formantBaseParam->load();
+    currentFormantPreservation = (getParamValue(Param::FormantCompensation) >= 0.5f);
+    currentTonalityHz          = getParamValue(Param::TonalityHz);
+    currentFormantBaseHz       = getParamValue(Param::FormantBaseHz);
+    currentFormantBaseAuto     = (getParamValue(Param::FormantBaseAuto) >= 0.5f);
 
-    currentTiltGainDB          = tiltGainDBParam->load();
+    currentTiltGainDB          = getParamValue(Param::TiltGainDb);
+    currentTiltCentreHz        = getParamValue(Param::TiltCentreHz);
+    currentTiltCentreAuto      = (getParamValue(Param::TiltCentreAuto) > 0.5f);
 }
 
 void SpectralShiftAudioProcessor::reset()
 {
-    stretch.reset();
+    postCommand({ Command::Type::Reset });
+}
+
+void SpectralShiftAudioProcessor::postCommand(Command command)
+{
+    const juce::SpinLock::ScopedLockType lock(commandProducerLock);
+
+    // The queue only fills if the audio thread has stopped; the next prepareToPlay resets anyway
+    if (!commands.push(command))
+        droppedCommands.fetch_add(1, std::memory_order_relaxed);
+}
+
+void SpectralShiftAudioProcessor::drainCommands()
+{
+    Command command;
+    while (commands.pop(command))
+    {
+        switch (command.type)
+        {
+            case Command::Type::Reset:
+                resetDsp();
+                break;
+
+            case Command::Type::PresetBegin:
+                // Bounded, so a lost PresetApplied can't freeze the parameters
+                parameterHoldSamples = static_cast<int>(getSampleRate() * presetHoldSeconds);
+                break;
+
+            case Command::Type::PresetApplied:
+                // Re-read every parameter, and let the auto modes start from the new sound
+                parameterHoldSamples = 0;
+                presetSwitchPending = true;
+                forceFullUpdate = true;
+                spectralCentroid.reset();
+                pitchTracker.reset();
+                break;
+
+            case Command::Type::ResetAnalysis:
+                spectralCentroid.reset();
+                pitchTracker.reset();
+                break;
+        }
+    }
+}
+
+void SpectralShiftAudioProcessor::resetDsp()
+{
+    if (activeEngine != nullptr)
+        activeEngine->reset();
+    inputHistory.reset();
+
+    // A pending outgoing engine is retired (or kept as the spare) by the next swapEngines()
+    crossfadeRemaining = 0;
+    parameterHoldSamples = 0;
+    presetSwitchPending = false;
+    pitchTracker.reset();
+    spectralCentroid.reset();
+    tiltEQ.reset();
+
+    #if PERFETTO
+    stretchInputTotal = 0;
+    #endif
+}
+
+void SpectralShiftAudioProcessor::warmUp()
+{
+    // Silence through every analysis stage, so the FFT and window tables and every
+    // arena page are warm before the first real block (engines warm up when built)
+    std::fill_n(monoBuffer, maxBlockSamples, 0.0f);
+    for (int done = 0; done < warmUpAnalysisSamples; done += maxBlockSamples)
+    {
+        spectralCentroid.processBlock(monoBuffer, maxBlockSamples);
+        pitchTracker.processBlock(monoBuffer, maxBlockSamples);
+    }
+
+    stretchBuffer.clear();
+    tiltEQ.process(stretchBuffer);
+    stretchBuffer.clear();
+
+    // prepareToPlay's reset() leaves the analysers and filter as if they had never run
 }
 
 void SpectralShiftAudioProcessor::createMonoSum(const juce::AudioBuffer<float>& buffer, int numSamples, int numChannels)
 {
+    const StageProfiler::ScopedStage stage(profiler, StageProfiler::Stage::MonoSum);
+
     #if PERFETTO
     TRACE_EVENT_BEGIN("dsp", "mono-sum");
     #endif
 
-    monoBuffer.resize(numSamples);
-    std::ranges::fill(monoBuffer, 0.0f);
+    std::fill_n(monoBuffer, numSamples, 0.0f);
 
     for (int ch = 0; ch < numChannels; ++ch)
     {
         const float* channelData = buffer.getReadPointer(ch);
         for (int i = 0; i < numSamples; ++i)
-            monoBuffer[static_cast<size_t>(i)] += channelData[i];
+            monoBuffer[i] += channelData[i];
     }
 
     const float invChannels = 1.0f / static_cast<float>(numChannels);
     for (int i = 0; i < numSamples; ++i)
-        monoBuffer[static_cast<size_t>(i)] *= invChannels;
+        monoBuffer[i] *= invChannels;
 
     #if PERFETTO
     TRACE_EVENT_END("dsp");
     #endif
 }
 
-void SpectralShiftAudioProcessor::processSpectralShift(juce::AudioBuffer<float>& buffer, int numSamples, int numChannels)
+void SpectralShiftAudioProcessor::processSpectralShift(const juce::AudioBuffer<float>& buffer, int startSample, int numSamples, int numChannels)
+{
+    // Advance the ramps to the end of this sub-block
+    const float pitchSemitones = smoothedPitchSemitones.skip(numSamples);
+    const float formantSemitones = smoothedFormantSemitones.skip(numSamples);
+
+    // Prepare input/output pointer arrays for this sub-block
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        inPtrs[ch] = buffer.getReadPointer(ch, startSample);
+        outPtrs[ch] = stretchBuffer.getWritePointer(ch, startSample);
+        fadePtrs[ch] = crossfadeBuffer.getWritePointer(ch);
+    }
+
+    // Process with Signalsmith Stretch
+    #if PERFETTO
+    TRACE_EVENT_BEGIN("dsp", "signalsmith-stretch");
+    #endif
+
+    applyStretchParameters(*activeEngine, pitchSemitones, formantSemitones);
+    activeEngine->process(inPtrs, outPtrs, numSamples);
+
+    if (fadingEngine != nullptr && crossfadeRemaining > 0)
+    {
+        // The outgoing engine keeps its last settings, so a preset switch fades from the old sound
+        fadingEngine->process(inPtrs, fadePtrs, numSamples);
+
+        const float step = 1.0f / static_cast<float>(crossfadeLength);
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            float outgoingGain = static_cast<float>(crossfadeRemaining) * step;
+            for (int i = 0; i < numSamples; ++i)
+            {
+                outgoingGain = juce::jmax(0.0f, outgoingGain - step);
+
+                if (crossfadeEqualPower)
+                {
+                    // Different settings give uncorrelated outputs, so keep the summed power constant
+                    const float angle = outgoingGain * juce::MathConstants<float>::halfPi;
+                    outPtrs[ch][i] = outPtrs[ch][i] * std::cos(angle) + fadePtrs[ch][i] * std::sin(angle);
+                }
+                else
+                {
+                    // Same settings at the same latency give correlated outputs, so a linear fade is flat
+                    outPtrs[ch][i] += (fadePtrs[ch][i] - outPtrs[ch][i]) * outgoingGain;
+                }
+            }
+        }
+
+        crossfadeRemaining -= numSamples;
+    }
+
+    #if PERFETTO
+    TRACE_EVENT_END("dsp");
+    #endif
+}
+
+void SpectralShiftAudioProcessor::applyStretchParameters(StretchEngine& engine, float pitchSemitones, float formantSemitones)
 {
-    const float pitchSemitones = currentPitchSemitones;
-    const float formantSemitones = currentFormantSemitones;
     const bool formantCompensation = currentFormantPreservation;
     const float tonalityHz = currentTonalityHz;
-    const float formantBaseHz = currentFormantBaseHz;
+    const float formantBaseHz = currentFormantBaseAuto ? pitchTracker.getFrequencyHz()
+                                                       : currentFormantBaseHz;
 
     const float sr = static_cast<float>(getSampleRate());
 
@@ -329,48 +829,142 @@ void SpectralShiftAudioProcessor::processSpectralShift(juce::AudioBuffer<float>&
         tonalityLimitNorm = juce::jlimit(0.0f, 0.5f, tonalityHz / sr);
     }
 
-    float safeFormantBaseHz = 0.0f;
-    if (formantBaseHz > 0.0f)
-        safeFormantBaseHz = juce::jlimit(minFormantBaseHz, maxFormantBaseHz, formantBaseHz);
+    // 0 lets the stretch estimate the fundamental itself
+    float formantBaseNorm = 0.0f;
+    if (formantBaseHz > 0.0f && sr > 0.0f)
+    {
+        // cycles/sample, same as the tonality limit
+        const float safeFormantBaseHz = juce::jlimit(minFormantBaseHz, maxFormantBaseHz, formantBaseHz);
+        formantBaseNorm = safeFormantBaseHz / sr;
+    }
 
-    stretch.setTransposeSemitones(pitchSemitones, tonalityLimitNorm);
-    stretch.setFormantSemitones(formantSemitones, formantCompensation);
-    //stretch.setFormantBase(safeFormantBaseHz);
-    stretch.setFormantBase(0.0f);
+    engine.setParameters(pitchSemitones, tonalityLimitNorm, formantSemitones, formantCompensation, formantBaseNorm);
+}
 
-    // Prepare input/output pointer arrays
-    for (int ch = 0; ch < numChannels; ++ch)
+void SpectralShiftAudioProcessor::applyQualityTier(CpuGovernor::Tier tier)
+{
+    // A different stretch preset is built in the background; swapEngines() crossfades it in
+    wantedQuality = getQualityForTier(tier);
+    if (activeEngine->getQuality() != wantedQuality)
     {
-        inPtrs[ch] = const_cast<float*>(buffer.getReadPointer(ch));
-        outPtrs[ch] = stretchBuffer.getWritePointer(ch);
+        engineBuilder.request(wantedQuality);
+        spareRequested = false;  // Superseded; swapEngines() asks again once the tier settles
     }
 
-    int inputSamples = numSamples;
-    int outputSamples = numSamples;
+    spectralCentroid.setUpdateDivisor(tier >= CpuGovernor::Tier::ReducedAnalysis ? 4 : 1);
 
-    // Process with Signalsmith Stretch
-    #if PERFETTO
-    TRACE_EVENT_BEGIN("dsp", "signalsmith-stretch");
-    #endif
+    // Frozen analysis holds the last centroid and pitch, so the tilt and formant base don't jump
+    analysisFrozen = tier == CpuGovernor::Tier::AnalysisOff;
+}
 
-    stretch.process(inPtrs.data(), inputSamples, outPtrs.data(), outputSamples);
+void SpectralShiftAudioProcessor::swapEngines()
+{
+    // The outgoing engine of a finished crossfade becomes the spare if it still fits, otherwise
+    // it goes back to be freed off the audio thread
+    if (fadingEngine != nullptr && crossfadeRemaining <= 0)
+    {
+        if (spareEngine == nullptr && fadingEngine->getQuality() == activeEngine->getQuality())
+            spareEngine = std::move(fadingEngine);
+        else
+            engineBuilder.retire(fadingEngine);
+    }
 
-    #if PERFETTO
-    TRACE_EVENT_END("dsp");
-    #endif
+    // A spare left over from another quality tier is no use for preset switches
+    if (spareEngine != nullptr && spareEngine->getQuality() != activeEngine->getQuality())
+        engineBuilder.retire(spareEngine);
+
+    if (spareEngine == nullptr && !spareRequested && wantedQuality == activeEngine->getQuality())
+    {
+        engineBuilder.request(wantedQuality);
+        spareRequested = true;
+    }
 
+    // One crossfade at a time; anything else waits for the current one to finish
+    if (fadingEngine != nullptr)
+    {
+        presetSwitchPending = false;  // The new values ramp in as automation would
+        return;
+    }
+
+    if (presetSwitchPending)
+    {
+        presetSwitchPending = false;
+
+        if (spareEngine != nullptr)
+        {
+            // Jump straight to the preset's values: the crossfade replaces the ramp
+            smoothedPitchSemitones.setCurrentAndTargetValue(currentPitchSemitones);
+            smoothedFormantSemitones.setCurrentAndTargetValue(currentFormantSemitones);
+
+            spareEngine->reset();
+            applyStretchParameters(*spareEngine, currentPitchSemitones, currentFormantSemitones);
+
+            const int primeLength = juce::jmin(spareEngine->getPrimeLength(), inputHistory.getLength());
+            spareEngine->prime(inputHistory.getLinear(primeLength), primeLength);
+
+            fadingEngine = std::move(activeEngine);
+            activeEngine = std::move(spareEngine);
+            crossfadeLength = presetCrossfadeSamples;
+            crossfadeRemaining = crossfadeLength;
+            crossfadeEqualPower = true;
+            return;
+        }
+    }
+
+    auto incoming = engineBuilder.takeReady();
+    if (incoming == nullptr)
+        return;
+
+    // The spare that was asked for
+    if (spareEngine == nullptr && incoming->getQuality() == activeEngine->getQuality())
+    {
+        spareEngine = std::move(incoming);
+        spareRequested = false;
+        return;
+    }
+
+    // Superseded while it was being built: retire it (or park it to be retired next block)
+    if (incoming->getQuality() != wantedQuality || incoming->getQuality() == activeEngine->getQuality())
+    {
+        if (! engineBuilder.retire(incoming))
+            fadingEngine = std::move(incoming);
+        return;
+    }
+
+    // Prime the incoming engine from recent input so it crossfades in at steady state
+    const int primeLength = juce::jmin(incoming->getPrimeLength(), inputHistory.getLength());
+    incoming->prime(inputHistory.getLinear(primeLength), primeLength);
+
+    fadingEngine = std::move(activeEngine);
+    activeEngine = std::move(incoming);
+    crossfadeLength = engineCrossfadeSamples;
+    crossfadeRemaining = crossfadeLength;
+    crossfadeEqualPower = false;
+}
+
+void SpectralShiftAudioProcessor::setGovernorEnabled(bool shouldBeEnabled)
+{
+    governor.setEnabled(shouldBeEnabled);
+    apvts.state.setProperty(governorEnabledID, shouldBeEnabled, nullptr);
+}
+
+void SpectralShiftAudioProcessor::setGovernorBudget(float fractionOfDeadline)
+{
+    governor.setBudget(fractionOfDeadline);
+    apvts.state.setProperty(governorBudgetID, governor.getBudget(), nullptr);
+}
+
+void SpectralShiftAudioProcessor::copyStretchOutput(juce::AudioBuffer<float>& buffer, int numSamples, int numChannels)
+{
     // Copy processed audio back into JUCE buffer
-    const int copySamples = std::min(numSamples, outputSamples);
+    const StageProfiler::ScopedStage stage(profiler, StageProfiler::Stage::BufferCopy);
 
     #if PERFETTO
     TRACE_EVENT_BEGIN("dsp", "buffer-copy");
     #endif
 
     for (int ch = 0; ch < numChannels; ++ch)
-    {
-        buffer.clear(ch, 0, numSamples);
-        buffer.copyFrom(ch, 0, stretchBuffer, ch, 0, copySamples);
-    }
+        buffer.copyFrom(ch, 0, stretchBuffer, ch, 0, numSamples);
 
     #if PERFETTO
     TRACE_EVENT_END("dsp");
@@ -383,8 +977,7 @@ void SpectralShiftAudioProcessor::calculateAndApplyTiltEQ(juce::AudioBuffer<floa
     TRACE_EVENT_BEGIN("dsp", "tilt-centre-calculation");
     #endif
 
-    auto* tiltCentreAutoParam = apvts.getRawParameterValue("TILT_CENTRE_AUTO");
-    bool isAuto = tiltCentreAutoParam->load() > 0.5f;
+    const bool isAuto = currentTiltCentreAuto;
 
     float tiltCentreHz;
     if (isAuto)
@@ -393,27 +986,27 @@ void SpectralShiftAudioProcessor::calculateAndApplyTiltEQ(juce::AudioBuffer<floa
         TRACE_EVENT_BEGIN("dsp", "spectral-centroid");
         #endif
 
-        // Use spectral centroid
-        spectralCentroid.processBlock(monoBuffer.data(), numSamples);
+        // Use spectral centroid (held at its last value while the governor has analysis off)
+        if (!analysisFrozen)
+        {
+            const StageProfiler::ScopedStage stage(profiler, StageProfiler::Stage::SpectralCentroid);
+            spectralCentroid.processBlock(monoBuffer, numSamples);
+        }
         tiltCentreHz = spectralCentroid.getCentroidHz();
 
         #if PERFETTO
         TRACE_EVENT_END("dsp");
         #endif
 
-        // Clamp to parameter range before updating slider
+        // Clamp to the manual parameter range so both modes cover the same span
         tiltCentreHz = juce::jlimit(minTiltCentreHz, maxTiltCentreHz, tiltCentreHz);
-
-        // Update the slider parameter value for visualization (without triggering listeners)
-        if (auto* param = apvts.getParameter("TILT_CENTRE_HZ"))
-            param->setValueNotifyingHost(param->getNormalisableRange().convertTo0to1(tiltCentreHz));
     }
     else
     {
-        auto* manualParam = apvts.getRawParameterValue("TILT_CENTRE_HZ");
-        tiltCentreHz = manualParam->load();
+        tiltCentreHz = currentTiltCentreHz;
     }
 
+    appliedTiltCentreHz = tiltCentreHz;
     tiltEQ.setCentreFrequency(tiltCentreHz);
     tiltEQ.setGainDb(currentTiltGainDB);
 
@@ -422,7 +1015,10 @@ void SpectralShiftAudioProcessor::calculateAndApplyTiltEQ(juce::AudioBuffer<floa
     TRACE_EVENT_BEGIN("dsp", "tilt-eq");
     #endif
 
-    tiltEQ.process(buffer);
+    {
+        const StageProfiler::ScopedStage stage(profiler, StageProfiler::Stage::TiltEQ);
+        tiltEQ.process(buffer);
+    }
 
     #if PERFETTO
     TRACE_EVENT_END("dsp");
@@ -432,6 +1028,7 @@ void SpectralShiftAudioProcessor::calculateAndApplyTiltEQ(juce::AudioBuffer<floa
 juce::AudioProcessorValueTreeState::ParameterLayout SpectralShiftAudioProcessor::createParameters()
 {
     std::vector<std::unique_ptr<juce::RangedAudioParameter>> parameters;
+    parameters.reserve(numParams);
 
     // Creates a function takes floats/ints and returns a string
     std::function<juce::String(float, int)> valueToTextFunction = [](float x, int l) { return juce::String(x, 4); };
@@ -441,48 +1038,52 @@ juce::AudioProcessorValueTreeState::ParameterLayout SpectralShiftAudioProcessor:
 
     // Pitch in semitones
     parameters.push_back(std::make_unique<juce::AudioParameterFloat>(
-        "PITCH_SEMITONES", "Pitch (semitones)",
+        toID(Param::PitchSemitones), "Pitch (semitones)",
         juce::NormalisableRange<float>(-semitonesRangeSt, semitonesRangeSt, 0.01f), 0.0f, "st",
         juce::AudioProcessorParameter::genericParameter, valueToTextFunction, textToValueFunction));
 
     // Pitch in cents
     parameters.push_back(std::make_unique<juce::AudioParameterFloat>(
-        "PITCH_CENTS", "Pitch (cents)",
+        toID(Param::PitchCents), "Pitch (cents)",
         juce::NormalisableRange<float>(-200.0f, 200.0f, 1.0f), 0.0f, "c",
         juce::AudioProcessorParameter::genericParameter, valueToTextFunction, textToValueFunction));
 
     // Formant in semitones
     parameters.push_back(std::make_unique<juce::AudioParameterFloat>(
-        "FORMANT_SEMITONES", "Formant (semitones)",
+        toID(Param::FormantSemitones), "Formant (semitones)",
         juce::NormalisableRange<float>(-semitonesRangeSt, semitonesRangeSt, 0.01f), 0.0f, "st",
         juce::AudioProcessorParameter::genericParameter, valueToTextFunction, textToValueFunction));
 
     // Formant in cents
     parameters.push_back(std::make_unique<juce::AudioParameterFloat>(
-        "FORMANT_CENTS", "Formant (cents)",
+        toID(Param::FormantCents), "Formant (cents)",
         juce::NormalisableRange<float>(-200.0f, 200.0f, 1.0f), 0.0f, "c",
         juce::AudioProcessorParameter::genericParameter, valueToTextFunction, textToValueFunction));
 
     parameters.push_back(std::make_unique<juce::AudioParameterBool>(
-        "FORMANT_COMPENSATION", "Formant Compensation", true));
+        toID(Param::FormantCompensation), "Formant Compensation", true));
 
     // Tonality Hz - logarithmic range centered at 2kHz
     auto tonalityRange = juce::NormalisableRange<float>(200.0f, 20000.0f, 10.0f);
     tonalityRange.setSkewForCentre(2000.0f);
     parameters.push_back(std::make_unique<juce::AudioParameterFloat>(
-        "TONALITY_HZ", "Tonality Hz",
+        toID(Param::TonalityHz), "Tonality Hz",
         tonalityRange, 5000.0f, "Hz",
         juce::AudioProcessorParameter::genericParameter, valueToTextFunction, textToValueFunction));
 
     parameters.push_back(std::make_unique<juce::AudioParameterFloat>(
-        "FORMANT_BASE_HZ", "Formant Base Hz",
+        toID(Param::FormantBaseHz), "Formant Base Hz",
         juce::NormalisableRange<float>(0.0f, 500.0f, 1.0f), 0.0f, "Hz",
         juce::AudioProcessorParameter::genericParameter, valueToTextFunction, textToValueFunction));
 
+    // Auto formant base: drive the formant base from the tracked input f0
+    parameters.push_back(std::make_unique<juce::AudioParameterBool>(
+        toID(Param::FormantBaseAuto), "Formant Base Auto", false));
+
     auto tiltGainRange = juce::NormalisableRange<float>(-6.0f, 6.0f, 0.001f);
     tiltGainRange.setSkewForCentre(0.0f);
     parameters.push_back(std::make_unique<juce::AudioParameterFloat>(
-        "TILT_GAIN_DB", "Tilt Gain db",
+        toID(Param::TiltGainDb), "Tilt Gain db",
         tiltGainRange, 0.0f, "dB",
         juce::AudioProcessorParameter::genericParameter, valueToTextFunction, textToValueFunction));
 
@@ -490,14 +1091,14 @@ juce::AudioProcessorValueTreeState::ParameterLayout SpectralShiftAudioProcessor:
     auto tiltCentreRange = juce::NormalisableRange<float>(200.0f, 20000.0f, 5.0f);
     tiltCentreRange.setSkewForCentre(1000.0f);
     parameters.push_back(std::make_unique<juce::AudioParameterFloat>(
-        "TILT_CENTRE_HZ",
+        toID(Param::TiltCentreHz),
         "Tilt Centre Hz",
         tiltCentreRange,
         1000.0f));
 
     // Auto tilt centre toggle (default ON)
     parameters.push_back(std::make_unique<juce::AudioParameterBool>(
-        "TILT_CENTRE_AUTO",
+        toID(Param::TiltCentreAuto),
         "Tilt Centre Auto",
         true));
 
@@ -10,23 +10,32 @@
 
 #include <juce_audio_basics/juce_audio_basics.h>
 #include <juce_audio_processors/juce_audio_processors.h>
-#include <signalsmith-stretch/signalsmith-stretch.h>
+#include "DSP/StretchEngine.h"
 #include "DSP/TiltEQ.h"
 #include "DSP/SpectralCentroid.h"
+#include "DSP/PitchTracker.h"
 #include "PresetManager.h"
-
-#if PERFETTO
-    #include <melatonin_perfetto/melatonin_perfetto.h>
-#endif
+#include "PluginState.h"
+#include "Parameters.h"
+#include "Utility/Telemetry.h"
+#include "Utility/StageProfiler.h"
+#include "Utility/DeadlineWatchdog.h"
+#include "Utility/SessionRecorder.h"
+#include "Utility/CpuGovernor.h"
+#include "Utility/Tracing.h"
+#include "Utility/SharedResources.h"
+#include "Utility/DspArena.h"
+#include "Utility/EngineBuilder.h"
+#include "Utility/SpscQueue.h"
 
 //==============================================================================
 /**
 */
-class SpectralShiftAudioProcessor  : public juce::AudioProcessor,
-                                      public juce::ValueTree::Listener
+class SpectralShiftAudioProcessor  : public juce::AudioProcessor
                             #if JucePlugin_Enable_ARA
                              , public juce::AudioProcessorARAExtension
                             #endif
+                             , private juce::AsyncUpdater
 {
 public:
     //==============================================================================
@@ -71,84 +80,256 @@ public:
     // Get current CPU load (0.0 to 1.0, where 1.0 = 100%)
     double getCpuLoad() const { return loadMeasurer.getLoadAsPercentage() / 100.0; }
 
+    // Live analysis values published by the audio thread
+    Telemetry& getTelemetry() { return telemetry; }
+
+    // Per-stage timing histograms (p50/p99/max), readable from any thread
+    StageProfiler& getProfiler() { return profiler; }
+
+    // Records host block sizes, parameters and (optionally) input audio for offline replay.
+    // Setting SPECTRALSHIFT_SESSION_TRACE to a directory records every session automatically.
+    bool startSessionRecording(const juce::File& file, bool includeAudio);
+    void stopSessionRecording() { sessionRecorder.stop(); }
+    bool isSessionRecording() const { return sessionRecorder.isRecording(); }
+
+#if PERFETTO
+    // Ends this instance's Perfetto session and moves the trace to destination
+    bool writePerfettoTrace(const juce::File& destination);
+#endif
+
+    // CPU budget governor; settings are stored with the plugin state
+    void setGovernorEnabled(bool shouldBeEnabled);
+    void setGovernorBudget(float fractionOfDeadline);
+    const CpuGovernor& getGovernor() const { return governor; }
+
+    // Name of the active quality tier, for display
+    juce::String getQualityModeName() const { return CpuGovernor::getTierName(governor.getTier()); }
+
     // Get preset manager for UI access
     PresetManager& getPresetManager() { return presetManager; }
 
-    // Pass sample rate and buffer size to DSP
-    void prepare(double sampleRate, int samplesPerBlock);
+    // Pass sample rate and buffer size to DSP; does nothing (and returns false) if they match the last call
+    bool prepare(double sampleRate, int samplesPerBlock);
 
-    // Called when user changes parameters
+    // Re-reads parameters and recomputes derived state for anything that changed
     void update();
 
-    // Reset DSP parameters
+    // Reset DSP state; safe from any thread, applied by the audio thread at its next block
     void reset() override;
 
+    // Clears the centroid and pitch tracker so auto tilt and formant base re-converge
+    void resetAnalysis() { postCommand({ Command::Type::ResetAnalysis }); }
+
+    // Commands lost because the queue was full (the audio thread wasn't draining it)
+    int getNumDroppedCommands() const { return droppedCommands.load(std::memory_order_relaxed); }
+
     // Store Parameters
     juce::AudioProcessorValueTreeState apvts;
     juce::AudioProcessorValueTreeState::ParameterLayout createParameters();
 
-    bool isSpectralReady { false };
     static constexpr float semitonesRangeSt = 24.0f;
-    // void setCurrentEnvelope(const std::vector<float>& envelope);
-
 
 private:
 
-    bool isActive{ false };
-    bool mustUpdateProcessing{ false };
+    std::atomic<bool> isActive { false };
+
+    // Control messages from other threads, drained at the top of processBlock. All
+    // cross-thread DSP control goes through here; parameters stay in APVTS atomics
+    struct Command
+    {
+        enum class Type
+        {
+            Reset,            // Clear all DSP state
+            PresetBegin,      // A preset's parameter values are about to be set
+            PresetApplied,    // A preset's parameter values have all been set
+            ResetAnalysis     // Clear the centroid and pitch tracker only
+        };
+
+        Type type { Type::Reset };
+        int presetIndex { -1 };
+    };
+    SpscQueue<Command, 64> commands;
+    juce::SpinLock commandProducerLock;   // Serialises producers; never taken by the audio thread
+    std::atomic<int> droppedCommands { 0 };
+
+    /** Any thread except the audio thread: queues a command for the next block. */
+    void postCommand(Command command);
+
+    /** Audio thread: applies every queued command. */
+    void drainCommands();
+
+    /** Audio thread (or with audio stopped): clears all DSP state. */
+    void resetDsp();
+
+    // Cached parameter atomics, indexed by Param, plus the values seen by the last update()
+    std::array<std::atomic<float>*, numParams> paramValues {};
+    std::array<juce::RangedAudioParameter*, numParams> paramHandles {};   // For restoring state
+
+    // Newest state from setStateInformation, until the message thread applies it
+    PluginState::State pendingState;
+    bool statePending { false };        // Under pendingStateLock
+    juce::uint32 pendingStateSerial { 0 };  // Under pendingStateLock; bumped by every restore
+    juce::SpinLock pendingStateLock;    // Never taken on the audio thread
+    std::array<float, numParams> lastParamValues {};
+    bool forceFullUpdate { true };      // Next update() treats every parameter as dirty
+
+    // The running stretch engine, the one being crossfaded out after a swap, and a warm spare
+    // of the active quality for preset switches. Replacements come from engineBuilder, are
+    // primed from recent input and share the same latency
+    std::unique_ptr<StretchEngine> activeEngine;
+    std::unique_ptr<StretchEngine> fadingEngine;
+    std::unique_ptr<StretchEngine> spareEngine;
+    StretchEngine::Quality wantedQuality { StretchEngine::Quality::Default };
+    bool spareRequested { false };
+    StretchHistory inputHistory;
+    int crossfadeRemaining { 0 };
+    int crossfadeLength { 0 };
+    bool crossfadeEqualPower { false };    // Preset switches fade between uncorrelated sounds
+    int engineCrossfadeSamples { 0 };
+    int presetCrossfadeSamples { 0 };
+
+    // Preset switches: parameter reads pause while a preset is applied, then the spare
+    // engine takes the new settings and crossfades in
+    int parameterHoldSamples { 0 };
+    bool presetSwitchPending { false };
+    juce::AudioBuffer<float> crossfadeBuffer;
 
-    signalsmith::stretch::SignalsmithStretch<float> stretch;
     float currentPitchSemitones { 0.0f };
     float currentFormantSemitones  { 0.0f };
     bool currentFormantPreservation { true };
     float currentTonalityHz { 0.0f };
     float currentFormantBaseHz { 0.0f };
+    bool currentFormantBaseAuto { false };
+
+    // Pitch/formant ramps, advanced once per sub-block
+    juce::SmoothedValue<float> smoothedPitchSemitones;
+    juce::SmoothedValue<float> smoothedFormantSemitones;
 
     TiltEQ tiltEQ;
     float currentTiltGainDB { 0.0f };
+    float currentTiltCentreHz { 1000.0f };
+    bool currentTiltCentreAuto { true };
+    float appliedTiltCentreHz { 1000.0f };
 
     SpectralCentroid spectralCentroid;
+    PitchTracker pitchTracker;
 
     // CPU load measurement
     juce::AudioProcessLoadMeasurer loadMeasurer;
 
+    // Audio-to-UI telemetry
+    Telemetry telemetry;
+
+    // Always-on stage timing
+    StageProfiler profiler;
+
+    // Steps quality down when this instance exceeds its CPU budget
+    CpuGovernor governor;
+    bool analysisFrozen { false };
+    static inline const juce::Identifier governorEnabledID { "cpuGovernor" };
+    static inline const juce::Identifier governorBudgetID { "cpuGovernorBudget" };
+
+    // Near-deadline block capture and session traces, written to disk by the shared IO thread
+    DeadlineWatchdog watchdog;
+    SessionRecorder sessionRecorder;
+
+    // Process-wide FFT tables and threads
+    juce::SharedResourcePointer<SharedResources> sharedResources;
+
+    // Builds replacement stretch engines on the shared worker pool
+    EngineBuilder engineBuilder { *sharedResources };
+
     // ===== Constants =====
     static constexpr float minTiltCentreHz = 200.0f;
     static constexpr float maxTiltCentreHz = 20000.0f;
     static constexpr float minFormantBaseHz = 20.0f;
     static constexpr float maxFormantBaseHz = 2000.0f;
+    static constexpr int automationQuantum = 64;        // Sub-block size for pitch/formant updates
+    static constexpr double automationRampSeconds = 0.05;
+    static constexpr double engineCrossfadeSeconds = 0.05;
+    static constexpr double presetCrossfadeSeconds = 0.03;
+    static constexpr double presetHoldSeconds = 0.1;    // Longest wait for PresetApplied before reading anyway
 
 #if PERFETTO
     MelatoninPerfetto perfettoSession;
+    juce::int64 stretchInputTotal { 0 };   // Samples fed to the stretch since the last reset
 #endif
 
+    // Every DSP buffer below (and the analysers' working memory) is carved from this
+    // arena in prepareToPlay, so the audio thread never allocates or page-faults
+    DspArena arena;
+
+    // Configuration the DSP was last built for, so repeated prepareToPlay calls skip the rebuild
+    struct PreparedConfig
+    {
+        double sampleRate { 0.0 };
+        int maxBlockSize { 0 };
+        int numChannels { 0 };
+
+        bool operator==(const PreparedConfig&) const = default;
+    };
+    PreparedConfig preparedConfig;
+    int preparedChannels { 0 };
+    int maxBlockSamples { 0 };
+    static constexpr int warmUpAnalysisSamples = 4096;  // Enough for several centroid FFTs and pitch frames
+
     juce::AudioBuffer<float> stretchBuffer;
-    std::vector<float> monoBuffer;
-    std::vector<float*> inPtrs, outPtrs;
+    float* monoBuffer { nullptr };
+    const float** inPtrs { nullptr };
+    float** outPtrs { nullptr };
+    float** fadePtrs { nullptr };
 
     // ===== Preset Management =====
     PresetManager presetManager;
 
+    // ===== ProcessBlock Helper Methods =====
+    /** Processes up to maxBlockSamples; processBlock() slices larger host blocks. */
+    void processSlice(juce::AudioBuffer<float>& buffer, int numSamples, int numChannels);
 
+    /** Runs silence through the analysers and tilt EQ so first-touch costs land in prepareToPlay. */
+    void warmUp();
 
+    /** Parses the XML state written by versions before PluginState. Returns false for malformed data. */
+    bool readLegacyState(const void* data, int sizeInBytes, PluginState::State& state) const;
 
+    /**
+     * Message thread: sets the parameters and governor from a state staged by
+     * setStateInformation(), if any. The DSP picks the values up at its next update().
+     */
+    void applyPendingState();
 
+    /** Applies a state staged from a thread other than the message thread. */
+    void handleAsyncUpdate() override { applyPendingState(); }
 
-    // ===== ProcessBlock Helper Methods =====
     /** Converts mono buffer from stereo input. */
     void createMonoSum(const juce::AudioBuffer<float>& buffer, int numSamples, int numChannels);
 
-    /** Processes spectral shift using signalsmith stretch. */
-    void processSpectralShift(juce::AudioBuffer<float>& buffer, int numSamples, int numChannels);
+    /** Applies the governor's current tier: engine choice and analysis rate. */
+    void applyQualityTier(CpuGovernor::Tier tier);
+
+    /** Stretch preset used by a governor tier. */
+    static StretchEngine::Quality getQualityForTier(CpuGovernor::Tier tier)
+    {
+        return tier == CpuGovernor::Tier::Full ? StretchEngine::Quality::Default : StretchEngine::Quality::Cheaper;
+    }
+
+    /** Audio thread: retires a faded-out engine, keeps a spare, and crossfades in new engines and presets. */
+    void swapEngines();
+
+    /** Hands the current shift settings (with the given pitch and formant) to an engine. */
+    void applyStretchParameters(StretchEngine& engine, float pitchSemitones, float formantSemitones);
+
+    /** Processes one sub-block of the spectral shift into stretchBuffer using signalsmith stretch. */
+    void processSpectralShift(const juce::AudioBuffer<float>& buffer, int startSample, int numSamples, int numChannels);
+
+    /** Copies the stretched audio back into the host buffer. */
+    void copyStretchOutput(juce::AudioBuffer<float>& buffer, int numSamples, int numChannels);
 
     /** Calculates tilt EQ center frequency and applies tilt filter. */
     void calculateAndApplyTiltEQ(juce::AudioBuffer<float>& buffer, int numSamples, int numChannels);
 
-    // Called when user changes a parameter
-    void valueTreePropertyChanged(juce::ValueTree& tree, const juce::Identifier& property) override
-    {
-        mustUpdateProcessing = true;
-    }
+    /** Returns the current plain value of a parameter from its cached atomic. */
+    float getParamValue(Param p) const { return paramValues[static_cast<size_t>(p)]->load(std::memory_order_relaxed); }
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SpectralShiftAudioProcessor)
 };
@@ -0,0 +1,150 @@
+//
+// Compact binary plugin state
+//
+
+#include "PluginState.h"
+#include <cstring>
+
+namespace
+{
+    /** Sequential little-endian writes into preallocated memory. */
+    struct Writer
+    {
+        char* position;
+
+        void writeUInt32(juce::uint32 value)
+        {
+            value = juce::ByteOrder::swapIfBigEndian(value);
+            std::memcpy(position, &value, sizeof(value));
+            position += sizeof(value);
+        }
+
+        void writeUInt16(juce::uint16 value)
+        {
+            value = juce::ByteOrder::swapIfBigEndian(value);
+            std::memcpy(position, &value, sizeof(value));
+            position += sizeof(value);
+        }
+
+        void writeUInt8(juce::uint8 value) { *position++ = static_cast<char>(value); }
+
+        void writeFloat(float value)
+        {
+            juce::uint32 bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            writeUInt32(bits);
+        }
+    };
+
+    /** Bounds-checked little-endian reads; any overrun clears ok. */
+    struct Reader
+    {
+        const char* position;
+        const char* end;
+        bool ok = true;
+
+        bool canRead(size_t bytes)
+        {
+            ok = ok && static_cast<size_t>(end - position) >= bytes;
+            return ok;
+        }
+
+        juce::uint32 readUInt32()
+        {
+            if (!canRead(sizeof(juce::uint32)))
+                return 0;
+
+            const auto value = juce::ByteOrder::littleEndianInt(position);
+            position += sizeof(juce::uint32);
+            return value;
+        }
+
+        juce::uint16 readUInt16()
+        {
+            if (!canRead(sizeof(juce::uint16)))
+                return 0;
+
+            const auto value = juce::ByteOrder::littleEndianShort(position);
+            position += sizeof(juce::uint16);
+            return value;
+        }
+
+        juce::uint8 readUInt8()
+        {
+            if (!canRead(1))
+                return 0;
+
+            return static_cast<juce::uint8>(*position++);
+        }
+
+        float readFloat()
+        {
+            const auto bits = readUInt32();
+            float value;
+            std::memcpy(&value, &bits, sizeof(value));
+            return value;
+        }
+    };
+}
+
+bool PluginState::isBinaryState(const void* data, int sizeInBytes)
+{
+    return data != nullptr
+        && sizeInBytes >= static_cast<int>(sizeof(juce::uint32))
+        && juce::ByteOrder::littleEndianInt(data) == magic;
+}
+
+void PluginState::write(const State& state, juce::MemoryBlock& dest)
+{
+    dest.setSize(getSize(), false);
+    Writer writer { static_cast<char*>(dest.getData()) };
+
+    writer.writeUInt32(magic);
+    writer.writeUInt16(version);
+    writer.writeUInt16(static_cast<juce::uint16>(numParams));
+
+    for (const auto value : state.values)
+        writer.writeFloat(value);
+
+    writer.writeUInt8(state.governorEnabled ? 1 : 0);
+    writer.writeFloat(state.governorBudget);
+
+    jassert(writer.position == static_cast<char*>(dest.getData()) + getSize());
+}
+
+bool PluginState::read(const void* data, int sizeInBytes, State& state)
+{
+    if (!isBinaryState(data, sizeInBytes))
+        return false;
+
+    const auto* start = static_cast<const char*>(data);
+    Reader reader { start + sizeof(juce::uint32), start + sizeInBytes };
+
+    const auto storedVersion = reader.readUInt16();
+    const int storedParams = reader.readUInt16();
+
+    if (!reader.ok || storedVersion == 0)
+        return false;
+
+    State parsed;
+
+    // Values for parameters this build doesn't know (from a newer version) are skipped
+    for (int i = 0; i < storedParams; ++i)
+    {
+        const float value = reader.readFloat();
+        if (i < numParams)
+        {
+            parsed.values[static_cast<size_t>(i)] = value;
+            parsed.present |= paramBit(static_cast<Param>(i));
+        }
+    }
+
+    parsed.governorEnabled = (reader.readUInt8() & 1) != 0;
+    parsed.governorBudget = reader.readFloat();
+
+    if (!reader.ok)
+        return false;
+
+    state = parsed;
+    return true;
+}
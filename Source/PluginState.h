@@ -0,0 +1,58 @@
+//
+// Compact binary plugin state
+//
+
+#pragma once
+#include <juce_core/juce_core.h>
+#include <array>
+#include "Parameters.h"
+
+/**
+ * Versioned binary layout for getStateInformation()/setStateInformation().
+ *
+ * Saving and loading a session touches every instance, so the state is a
+ * fixed little-endian record written and read in one pass, without XML or
+ * ValueTrees:
+ *
+ *     uint32  magic ("SSST")
+ *     uint16  version
+ *     uint16  number of parameter values that follow
+ *     float32 plain parameter values, in Param order
+ *     uint8   flags (bit 0: CPU governor enabled)
+ *     float32 CPU governor budget
+ *
+ * New parameters are only ever appended to Param, so older states simply
+ * carry fewer values; values they lack are left out of State::present and
+ * left unchanged. Fields added in later versions go after the existing ones.
+ */
+namespace PluginState
+{
+    struct State
+    {
+        std::array<float, numParams> values {};   // Plain values; only meaningful where present
+        uint32_t present { 0 };                     // paramBit() of every value the state holds
+        bool governorEnabled { false };
+        float governorBudget { 0.0f };
+    };
+
+    inline constexpr juce::uint32 magic = 0x54535353;   // "SSST" read little-endian
+    inline constexpr juce::uint16 version = 1;
+
+    /** Bytes written by write(). */
+    constexpr size_t getSize()
+    {
+        return sizeof(juce::uint32) + 2 * sizeof(juce::uint16) + numParams * sizeof(float) + 1 + sizeof(float);
+    }
+
+    /** True if data starts with the binary state magic (otherwise it may be a legacy XML state). */
+    bool isBinaryState(const void* data, int sizeInBytes);
+
+    /**
+     * Replaces dest's contents with state; allocates only if dest is smaller than getSize().
+     * Every value is written, so fill in any absent ones first.
+     */
+    void write(const State& state, juce::MemoryBlock& dest);
+
+    /** Parses a binary state. Returns false (leaving state untouched) if data is not a valid one. */
+    bool read(const void* data, int sizeInBytes, State& state);
+}
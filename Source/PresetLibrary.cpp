@@ -0,0 +1,381 @@
+//
+// On-disk user preset library
+//
+
+#include "PresetLibrary.h"
+#include <algorithm>
+#include <map>
+
+PresetLibrary::PresetLibrary()
+    : directory(getDefaultDirectory()),
+      indexFile(directory.getParentDirectory().getChildFile("PresetIndex.bin")),
+      snapshot(std::make_shared<Snapshot>())
+{
+    shared->getIOThread().addTimeSliceClient(this);
+}
+
+PresetLibrary::~PresetLibrary()
+{
+    shared->getIOThread().removeTimeSliceClient(this);
+}
+
+juce::File PresetLibrary::getDefaultDirectory()
+{
+    return juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+        .getChildFile("trencrumb")
+        .getChildFile("Spectral Shift")
+        .getChildFile("Presets");
+}
+
+std::shared_ptr<const PresetLibrary::Snapshot> PresetLibrary::getSnapshot() const
+{
+    const juce::ScopedLock sl(snapshotLock);
+    return snapshot;
+}
+
+juce::File PresetLibrary::save(const juce::String& name, const juce::StringArray& tags,
+                               const std::array<float, numParams>& values, uint32_t present,
+                               const juce::File& existingFile)
+{
+    directory.createDirectory();
+
+    auto file = existingFile;
+    if (file == juce::File())
+    {
+        const auto baseName = juce::File::createLegalFileName(name).trim();
+        file = directory.getNonexistentChildFile(baseName.isNotEmpty() ? baseName : "Preset", fileExtension, false);
+    }
+
+    Entry entry;
+    entry.name = name;
+    entry.tags = tags;
+    entry.values = values;
+    entry.present = present;
+
+    if (!writePresetFile(file, entry))
+        return {};
+
+    rescanSoon();
+    return file;
+}
+
+bool PresetLibrary::remove(const juce::File& file)
+{
+    const bool deleted = file.isAChildOf(directory) && file.deleteFile();
+    rescanSoon();
+    return deleted;
+}
+
+//==============================================================================
+bool PresetLibrary::readPresetFile(const juce::File& file, Entry& entry)
+{
+    const auto xml = juce::XmlDocument::parse(file);
+    if (xml == nullptr || !xml->hasTagName("SpectralShiftPreset"))
+        return false;
+
+    entry.name = xml->getStringAttribute("name", file.getFileNameWithoutExtension());
+    entry.tags = juce::StringArray::fromTokens(xml->getStringAttribute("tags"), ";", "");
+    entry.tags.trim();
+    entry.tags.removeEmptyStrings();
+    entry.values = {};
+    entry.present = 0;
+
+    for (auto* param : xml->getChildWithTagNameIterator("PARAM"))
+    {
+        const auto id = param->getStringAttribute("id");
+        for (int i = 0; i < numParams; ++i)
+            if (id == paramIDs[static_cast<size_t>(i)])
+            {
+                entry.values[static_cast<size_t>(i)] = static_cast<float>(param->getDoubleAttribute("value"));
+                entry.present |= paramBit(static_cast<Param>(i));
+            }
+    }
+
+    return true;
+}
+
+bool PresetLibrary::writePresetFile(const juce::File& file, const Entry& entry)
+{
+    juce::XmlElement xml("SpectralShiftPreset");
+    xml.setAttribute("version", 1);
+    xml.setAttribute("name", entry.name);
+    xml.setAttribute("tags", entry.tags.joinIntoString(";"));
+
+    for (int i = 0; i < numParams; ++i)
+    {
+        if ((entry.present & paramBit(static_cast<Param>(i))) == 0)
+            continue;
+
+        auto* param = xml.createNewChildElement("PARAM");
+        param->setAttribute("id", paramIDs[static_cast<size_t>(i)]);
+        param->setAttribute("value", entry.values[static_cast<size_t>(i)]);
+    }
+
+    return xml.writeTo(file);
+}
+
+//==============================================================================
+int PresetLibrary::useTimeSlice()
+{
+    if (!indexLoaded)
+    {
+        // The cached index shows the library immediately; the scan below then corrects it
+        indexLoaded = true;
+        loadIndex();
+    }
+
+    const double now = juce::Time::getMillisecondCounterHiRes();
+    if (rescanRequested.exchange(false, std::memory_order_relaxed) || now - lastScanMs >= rescanIntervalMs)
+    {
+        lastScanMs = now;
+        scan();
+    }
+
+    return 250;
+}
+
+void PresetLibrary::scan()
+{
+    if (!directory.isDirectory())
+    {
+        if (!getSnapshot()->entries.empty())
+            publish({});
+        return;
+    }
+
+    const auto current = getSnapshot();
+
+    // Unchanged files (same size and modification time) keep their parsed entry
+    std::map<juce::String, const Entry*> known;
+    for (const auto& entry : current->entries)
+        known.emplace(entry.file.getFullPathName(), &entry);
+
+    std::vector<Entry> entries;
+    entries.reserve(current->entries.size());
+    bool changed = false;
+
+    for (const auto& item : juce::RangedDirectoryIterator(directory, true, juce::String("*") + fileExtension, juce::File::findFiles))
+    {
+        const auto file = item.getFile();
+        const auto modificationTime = item.getModificationTime().toMilliseconds();
+        const auto size = item.getFileSize();
+
+        const auto found = known.find(file.getFullPathName());
+        if (found != known.end() && found->second->modificationTime == modificationTime && found->second->size == size)
+        {
+            entries.push_back(*found->second);
+            continue;
+        }
+
+        changed = true;
+
+        Entry entry;
+        if (!readPresetFile(file, entry))
+            continue;
+
+        entry.file = file;
+        entry.modificationTime = modificationTime;
+        entry.size = size;
+        entries.push_back(std::move(entry));
+    }
+
+    // Anything known but not seen again was deleted
+    if (changed || entries.size() != current->entries.size())
+        publish(std::move(entries));
+}
+
+void PresetLibrary::publish(std::vector<Entry> entries, bool writeIndex)
+{
+    auto newSnapshot = std::make_shared<Snapshot>();
+
+    std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b)
+    {
+        return a.name.compareNatural(b.name) < 0;
+    });
+
+    for (auto& entry : entries)
+        entry.searchName = entry.name.toLowerCase();
+
+    newSnapshot->entries = std::move(entries);
+
+    for (int i = 0; i < static_cast<int>(newSnapshot->entries.size()); ++i)
+    {
+        const auto& entry = newSnapshot->entries[static_cast<size_t>(i)];
+        addWords(entry.searchName, i, newSnapshot->words);
+        for (const auto& tag : entry.tags)
+            addWords(tag.toLowerCase(), i, newSnapshot->words);
+    }
+
+    std::sort(newSnapshot->words.begin(), newSnapshot->words.end());
+
+    if (writeIndex)
+        saveIndex(*newSnapshot);
+
+    {
+        const juce::ScopedLock sl(snapshotLock);
+        snapshot = std::move(newSnapshot);
+    }
+
+    sendChangeMessage();
+}
+
+//==============================================================================
+bool PresetLibrary::loadIndex()
+{
+    juce::FileInputStream in(indexFile);
+    if (!in.openedOk()
+        || in.readInt() != indexMagic
+        || in.readInt() != indexVersion
+        || in.readInt() != numParams)
+        return false;
+
+    const int count = in.readInt();
+    if (count < 0)
+        return false;
+
+    std::vector<Entry> entries;
+    entries.reserve(static_cast<size_t>(count));
+
+    for (int i = 0; i < count && !in.isExhausted(); ++i)
+    {
+        Entry entry;
+        entry.file = juce::File(in.readString());
+        entry.modificationTime = in.readInt64();
+        entry.size = in.readInt64();
+        entry.name = in.readString();
+        entry.tags = juce::StringArray::fromTokens(in.readString(), ";", "");
+        entry.tags.removeEmptyStrings();
+
+        for (auto& value : entry.values)
+            value = in.readFloat();
+
+        entry.present = static_cast<uint32_t>(in.readInt()) & allParamBits;
+
+        entries.push_back(std::move(entry));
+    }
+
+    if (static_cast<int>(entries.size()) != count)
+        return false;
+
+    publish(std::move(entries), false);
+    return true;
+}
+
+void PresetLibrary::saveIndex(const Snapshot& newSnapshot) const
+{
+    juce::MemoryOutputStream out;
+    out.writeInt(indexMagic);
+    out.writeInt(indexVersion);
+    out.writeInt(numParams);
+    out.writeInt(static_cast<int>(newSnapshot.entries.size()));
+
+    for (const auto& entry : newSnapshot.entries)
+    {
+        out.writeString(entry.file.getFullPathName());
+        out.writeInt64(entry.modificationTime);
+        out.writeInt64(entry.size);
+        out.writeString(entry.name);
+        out.writeString(entry.tags.joinIntoString(";"));
+
+        for (const auto value : entry.values)
+            out.writeFloat(value);
+
+        out.writeInt(static_cast<int>(entry.present));
+    }
+
+    indexFile.getParentDirectory().createDirectory();
+    indexFile.replaceWithData(out.getData(), out.getDataSize());
+}
+
+//==============================================================================
+std::vector<int> PresetLibrary::search(const Snapshot& snapshot, const juce::String& query, int maxResults)
+{
+    const int numEntries = static_cast<int>(snapshot.entries.size());
+    std::vector<int> results;
+
+    auto tokens = juce::StringArray::fromTokens(query.toLowerCase(), " \t-_", "");
+    tokens.removeEmptyStrings();
+
+    if (tokens.isEmpty())
+    {
+        for (int i = 0; i < juce::jmin(numEntries, maxResults); ++i)
+            results.push_back(i);
+        return results;
+    }
+
+    // Summed over the query words; -1 marks an entry that failed one of them
+    std::vector<int> scores(static_cast<size_t>(numEntries), 0);
+    std::vector<int> tokenScores(static_cast<size_t>(numEntries));
+
+    for (const auto& token : tokens)
+    {
+        std::fill(tokenScores.begin(), tokenScores.end(), 0);
+
+        // Prefix matches straight from the sorted word index
+        auto word = std::lower_bound(snapshot.words.begin(), snapshot.words.end(), std::make_pair(token, -1));
+        for (; word != snapshot.words.end() && word->first.startsWith(token); ++word)
+        {
+            const int score = word->first.length() == token.length() ? 300 : 200;
+            auto& best = tokenScores[static_cast<size_t>(word->second)];
+            best = juce::jmax(best, score);
+        }
+
+        for (int i = 0; i < numEntries; ++i)
+        {
+            const auto index = static_cast<size_t>(i);
+            if (scores[index] < 0)
+                continue;
+
+            if (tokenScores[index] == 0)
+                tokenScores[index] = fuzzyScore(snapshot.entries[index].searchName, token);
+
+            scores[index] = tokenScores[index] > 0 ? scores[index] + tokenScores[index] : -1;
+        }
+    }
+
+    for (int i = 0; i < numEntries; ++i)
+        if (scores[static_cast<size_t>(i)] > 0)
+            results.push_back(i);
+
+    // Best score first; the snapshot is already in name order for ties
+    std::stable_sort(results.begin(), results.end(), [&scores](int a, int b)
+    {
+        return scores[static_cast<size_t>(a)] > scores[static_cast<size_t>(b)];
+    });
+
+    if (static_cast<int>(results.size()) > maxResults)
+        results.resize(static_cast<size_t>(juce::jmax(0, maxResults)));
+
+    return results;
+}
+
+void PresetLibrary::addWords(const juce::String& text, int entryIndex, std::vector<std::pair<juce::String, int>>& words)
+{
+    auto tokens = juce::StringArray::fromTokens(text, " \t-_", "");
+    tokens.removeEmptyStrings();
+
+    for (const auto& token : tokens)
+        words.emplace_back(token, entryIndex);
+}
+
+int PresetLibrary::fuzzyScore(const juce::String& text, const juce::String& pattern)
+{
+    // Every pattern character must appear in order; tighter matches score higher (1..99)
+    int position = 0;
+    int first = -1;
+
+    for (auto character : pattern)
+    {
+        position = text.indexOfChar(position, character);
+        if (position < 0)
+            return 0;
+
+        if (first < 0)
+            first = position;
+        ++position;
+    }
+
+    const int span = position - first;
+    const int gaps = span - pattern.length();
+    return juce::jlimit(1, 99, 99 - gaps * 4 - first);
+}
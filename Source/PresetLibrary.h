@@ -0,0 +1,114 @@
+//
+// On-disk user preset library
+//
+
+#pragma once
+#include <juce_audio_processors/juce_audio_processors.h>
+#include <array>
+#include <memory>
+#include <vector>
+#include "Parameters.h"
+#include "Utility/SharedResources.h"
+
+/**
+ * User presets stored as one small XML file each in a library directory, so
+ * they survive reloads and can be copied or synced between machines.
+ *
+ * Shared by every instance through juce::SharedResourcePointer. The shared
+ * IO thread loads a binary index cache on startup (so thousands of presets
+ * appear without parsing a file), then polls the directory and re-reads
+ * only files whose size or modification time changed. Each change publishes
+ * a new immutable Snapshot and sends a change message on the message thread.
+ *
+ * Parameters are stored by ID; an entry's present mask records which ones
+ * its file holds, and PresetManager leaves the rest unchanged.
+ */
+class PresetLibrary : public juce::TimeSliceClient,
+                      public juce::ChangeBroadcaster
+{
+public:
+    struct Entry
+    {
+        juce::File file;
+        juce::int64 modificationTime = 0;   // Milliseconds since the epoch
+        juce::int64 size = 0;
+        juce::String name;
+        juce::StringArray tags;
+        std::array<float, numParams> values {};
+        uint32_t present = 0;               // paramBit() of each value the file holds
+        juce::String searchName;            // Lower-case name, for fuzzy matching
+    };
+
+    struct Snapshot
+    {
+        std::vector<Entry> entries;                        // Sorted by name
+        std::vector<std::pair<juce::String, int>> words;   // Lower-case name/tag words -> entry, sorted
+    };
+
+    static constexpr const char* fileExtension = ".sspreset";
+
+    PresetLibrary();
+    ~PresetLibrary() override;
+
+    static juce::File getDefaultDirectory();
+
+    /** The latest scan of the library; never null. */
+    std::shared_ptr<const Snapshot> getSnapshot() const;
+
+    /**
+     * Writes a preset file holding the values whose bit is set in present and
+     * schedules a rescan. Overwrites existingFile if given, otherwise picks a
+     * new file named after the preset. Returns the file written, or an empty
+     * File on failure.
+     */
+    juce::File save(const juce::String& name, const juce::StringArray& tags,
+                    const std::array<float, numParams>& values, uint32_t present,
+                    const juce::File& existingFile = {});
+
+    /** Deletes a preset file and schedules a rescan. */
+    bool remove(const juce::File& file);
+
+    /** Asks the IO thread to rescan at its next slice. */
+    void rescanSoon() { rescanRequested.store(true, std::memory_order_relaxed); }
+
+    /**
+     * Indices into snapshot.entries matching query, best first. Each word of
+     * the query must prefix-match a word of the name or tags, or appear in
+     * order (fuzzily) in the name; whole-word and prefix matches rank first.
+     */
+    static std::vector<int> search(const Snapshot& snapshot, const juce::String& query, int maxResults);
+
+    static bool readPresetFile(const juce::File& file, Entry& entry);
+    static bool writePresetFile(const juce::File& file, const Entry& entry);
+
+    /** IO thread: loads the index cache, then rescans when due. */
+    int useTimeSlice() override;
+
+private:
+    static constexpr int indexMagic = 0x49505353;   // "SSPI"
+    static constexpr int indexVersion = 2;
+    static constexpr double rescanIntervalMs = 2000.0;
+
+    juce::SharedResourcePointer<SharedResources> shared;
+
+    juce::File directory;
+    juce::File indexFile;
+
+    mutable juce::CriticalSection snapshotLock;
+    std::shared_ptr<const Snapshot> snapshot;
+
+    // IO thread only
+    bool indexLoaded = false;
+    double lastScanMs = 0.0;
+    std::atomic<bool> rescanRequested { true };
+
+    void scan();
+    void publish(std::vector<Entry> entries, bool writeIndex = true);
+    bool loadIndex();
+    void saveIndex(const Snapshot& newSnapshot) const;
+
+    static void addWords(const juce::String& text, int entryIndex, std::vector<std::pair<juce::String, int>>& words);
+    static int fuzzyScore(const juce::String& text, const juce::String& pattern);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PresetLibrary)
+};
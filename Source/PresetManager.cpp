@@ -3,85 +3,182 @@
 //
 
 #include "PresetManager.h"
+#include "Parameters.h"
+
+namespace
+{
+    // Values in Param order: pitch st, pitch ct, formant st, formant ct, formant compensation,
+    // tonality Hz, formant base Hz, formant base auto, tilt dB, tilt centre Hz, tilt centre auto
+    constexpr std::array<PresetManager::FactoryPreset, 8> factoryPresets {{
+        { "Default", { 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 5000.0f, 0.0f, 0.0f, 0.0f, 1000.0f, 1.0f } },
+        { "Subtle Brighten", { 2.0f, 0.0f, 1.0f, 0.0f, 0.0f, 6000.0f, 0.0f, 0.0f, 1.5f, 1000.0f, 1.0f } },
+        { "Thick Low", { 7.0f, 0.0f, -5.0f, 0.0f, 1.0f, 3000.0f, 0.0f, 0.0f, -2.0f, 1000.0f, 1.0f } },
+        { "Chipmunk", { 12.0f, 0.0f, 10.0f, 0.0f, 0.0f, 8000.0f, 0.0f, 0.0f, 2.0f, 1000.0f, 1.0f } },
+        { "Deep Monster", { -12.0f, 0.0f, -7.0f, 0.0f, 1.0f, 2000.0f, 0.0f, 0.0f, -3.0f, 200.0f, 0.0f } },
+        { "Shimmer", { 5.0f, 0.0f, 3.0f, 0.0f, 1.0f, 10000.0f, 0.0f, 0.0f, 4.0f, 1000.0f, 1.0f } },
+        { "Higher Voice", { 0.0f, 0.0f, 4.0f, 0.0f, 1.0f, 6000.0f, 0.0f, 0.0f, 1.0f, 1000.0f, 1.0f } },
+        { "Lower Voice", { 0.0f, 0.0f, -4.0f, 0.0f, 1.0f, 4000.0f, 0.0f, 0.0f, -1.0f, 1000.0f, 1.0f } }
+    }};
+}
+
+const int PresetManager::numFactoryPresets = static_cast<int>(factoryPresets.size());
 
 PresetManager::PresetManager()
 {
-    initializeFactoryPresets();
-    numFactoryPresets = static_cast<int>(presets.size());
+    loadUserPresets();
+    library->addChangeListener(this);
+}
+
+PresetManager::~PresetManager()
+{
+    library->removeChangeListener(this);
 }
 
 juce::String PresetManager::getPresetName(int index) const
 {
-    if (index < 0 || index >= static_cast<int>(presets.size()))
+    if (index < 0 || index >= getNumPresets())
         return {};
 
-    return presets[static_cast<size_t>(index)].name;
+    if (index < numFactoryPresets)
+        return factoryPresets[static_cast<size_t>(index)].name;
+
+    return userPresets[static_cast<size_t>(index - numFactoryPresets)].name;
 }
 
-const PresetManager::Preset* PresetManager::getPreset(int index) const
+const std::array<float, numParams>* PresetManager::getPresetValues(int index) const
 {
-    if (index < 0 || index >= static_cast<int>(presets.size()))
+    if (index < 0 || index >= getNumPresets())
         return nullptr;
 
-    return &presets[static_cast<size_t>(index)];
+    if (index < numFactoryPresets)
+        return &factoryPresets[static_cast<size_t>(index)].values;
+
+    return &userPresets[static_cast<size_t>(index - numFactoryPresets)].values;
+}
+
+uint32_t PresetManager::getPresetMask(int index) const
+{
+    if (index < 0 || index >= getNumPresets())
+        return 0;
+
+    if (index < numFactoryPresets)
+        return allParamBits;
+
+    return userPresets[static_cast<size_t>(index - numFactoryPresets)].present;
+}
+
+PresetManager::Preset* PresetManager::getUserPreset(int index)
+{
+    if (index < numFactoryPresets || index >= getNumPresets())
+        return nullptr;
+
+    return &userPresets[static_cast<size_t>(index - numFactoryPresets)];
+}
+
+int PresetManager::findPreset(const juce::File& file) const
+{
+    if (file == juce::File())
+        return -1;
+
+    for (size_t i = 0; i < userPresets.size(); ++i)
+        if (userPresets[i].file == file)
+            return numFactoryPresets + static_cast<int>(i);
+
+    return -1;
+}
+
+void PresetManager::attach(juce::AudioProcessorValueTreeState& apvts)
+{
+    for (int i = 0; i < numParams; ++i)
+    {
+        parameters[static_cast<size_t>(i)] = apvts.getParameter(paramIDs[static_cast<size_t>(i)]);
+        jassert(parameters[static_cast<size_t>(i)] != nullptr);
+    }
 }
 
-bool PresetManager::applyPreset(int index, const juce::AudioProcessorValueTreeState& apvts)
+bool PresetManager::applyPreset(int index)
 {
-    if (index < 0 || index >= static_cast<int>(presets.size()))
+    const auto* values = getPresetValues(index);
+    if (values == nullptr)
         return false;
 
-    const auto& preset = presets[static_cast<size_t>(index)];
+    const uint32_t present = getPresetMask(index);
 
-    // Apply all parameter values from the preset
-    for (const auto& [paramID, value] : preset.values)
+    // Only parameters that actually change are touched, so the host and listeners hear nothing else
+    std::array<float, numParams> normalised {};
+    uint32_t changed = 0;
+
+    for (int i = 0; i < numParams; ++i)
     {
-        if (auto* param = apvts.getParameter(paramID))
-        {
-            const auto normalizedValue = param->getNormalisableRange().convertTo0to1(value);
-            param->setValueNotifyingHost(normalizedValue);
-        }
+        const auto p = static_cast<size_t>(i);
+        if (parameters[p] == nullptr || (present & (1u << i)) == 0)
+            continue;
+
+        normalised[p] = parameters[p]->convertTo0to1((*values)[p]);
+        if (parameters[p]->getValue() != normalised[p])
+            changed |= 1u << i;
     }
 
+    // One gesture around the whole preset, so hosts record it as a single edit
+    for (int i = 0; i < numParams; ++i)
+        if (changed & (1u << i))
+            parameters[static_cast<size_t>(i)]->beginChangeGesture();
+
+    for (int i = 0; i < numParams; ++i)
+        if (changed & (1u << i))
+            parameters[static_cast<size_t>(i)]->setValueNotifyingHost(normalised[static_cast<size_t>(i)]);
+
+    for (int i = 0; i < numParams; ++i)
+        if (changed & (1u << i))
+            parameters[static_cast<size_t>(i)]->endChangeGesture();
+
     currentPresetIndex = index;
     return true;
 }
 
-void PresetManager::savePreset(const juce::String& name, const juce::AudioProcessorValueTreeState& apvts)
+void PresetManager::savePreset(const juce::String& name)
 {
     Preset newPreset;
     newPreset.name = name;
 
-    // Get all parameters from APVTS
-    for (auto* param : apvts.processor.getParameters())
-    {
-        if (auto* rangedParam = dynamic_cast<juce::RangedAudioParameter*>(param))
-        {
-            const auto paramID = rangedParam->getParameterID();
-            const auto value = rangedParam->getNormalisableRange().convertFrom0to1(rangedParam->getValue());
-            newPreset.values[paramID] = value;
-        }
-    }
+    for (int i = 0; i < numParams; ++i)
+        if (auto* parameter = parameters[static_cast<size_t>(i)])
+            newPreset.values[static_cast<size_t>(i)] = parameter->convertFrom0to1(parameter->getValue());
+
+    newPreset.file = library->save(name, {}, newPreset.values, newPreset.present);
 
-    presets.push_back(newPreset);
-    currentPresetIndex = static_cast<int>(presets.size()) - 1;
+    // Shown straight away; the library's rescan replaces it with the entry read back from disk
+    userPresets.push_back(newPreset);
+    currentPresetIndex = getNumPresets() - 1;
 }
 
 void PresetManager::renamePreset(int index, const juce::String& newName)
 {
-    if (index < 0 || index >= static_cast<int>(presets.size()))
+    auto* preset = getUserPreset(index);
+    if (preset == nullptr)
         return;
 
-    presets[static_cast<size_t>(index)].name = newName;
+    preset->name = newName;
+
+    if (preset->file != juce::File())
+    {
+        PresetLibrary::Entry entry;
+        if (PresetLibrary::readPresetFile(preset->file, entry))
+            library->save(newName, entry.tags, entry.values, entry.present, preset->file);
+    }
 }
 
 bool PresetManager::deletePreset(int index)
 {
     // Cannot delete factory presets
-    if (index < 0 || index >= static_cast<int>(presets.size()) || index < numFactoryPresets)
+    const auto* preset = getUserPreset(index);
+    if (preset == nullptr)
         return false;
 
-    presets.erase(presets.begin() + index);
+    if (preset->file != juce::File())
+        library->remove(preset->file);
+
+    userPresets.erase(userPresets.begin() + (index - numFactoryPresets));
 
     // Update current preset index if needed
     if (currentPresetIndex == index)
@@ -94,139 +191,33 @@ bool PresetManager::deletePreset(int index)
 
 void PresetManager::resetToFactoryPresets()
 {
-    presets.clear();
-    initializeFactoryPresets();
-    numFactoryPresets = static_cast<int>(presets.size());
     currentPresetIndex = -1;
+    loadUserPresets();
+}
+
+void PresetManager::loadUserPresets()
+{
+    // Keep the current selection across rescans by following its file
+    const auto* current = getUserPreset(currentPresetIndex);
+    const auto currentFile = current != nullptr ? current->file : juce::File();
+    const bool currentIsUser = current != nullptr;
+
+    const auto snapshot = library->getSnapshot();
+
+    userPresets.clear();
+    userPresets.reserve(snapshot->entries.size());
+
+    for (const auto& entry : snapshot->entries)
+        userPresets.push_back({ entry.name, entry.values, entry.present, entry.file });
+
+    if (currentIsUser)
+        currentPresetIndex = findPreset(currentFile);
 }
 
-void PresetManager::initializeFactoryPresets()
-{
-    presets.push_back({
-        "Default",
-        {
-            { "PITCH_SEMITONES", 0.0f },
-            { "PITCH_CENTS", 0.0f },
-            { "FORMANT_SEMITONES", 0.0f },
-            { "FORMANT_CENTS", 0.0f },
-            { "FORMANT_COMPENSATION", 1.0f },
-            { "TONALITY_HZ", 5000.0f },
-            { "FORMANT_BASE_HZ", 0.0f },
-            { "TILT_GAIN_DB", 0.0f },
-            { "TILT_CENTRE_HZ", 1000.0f },
-            { "TILT_CENTRE_AUTO", 1.0f }
-        }
-    });
-
-    presets.push_back({
-        "Subtle Brighten",
-        {
-            { "PITCH_SEMITONES", 2.0f },
-            { "PITCH_CENTS", 0.0f },
-            { "FORMANT_SEMITONES", 1.0f },
-            { "FORMANT_CENTS", 0.0f },
-            { "FORMANT_COMPENSATION", 0.0f },
-            { "TONALITY_HZ", 6000.0f },
-            { "FORMANT_BASE_HZ", 0.0f },
-            { "TILT_GAIN_DB", 1.5f },
-            { "TILT_CENTRE_HZ", 1000.0f },
-            { "TILT_CENTRE_AUTO", 1.0f }
-        }
-    });
-
-    presets.push_back({
-        "Thick Low",
-        {
-            { "PITCH_SEMITONES", 7.0f },
-            { "PITCH_CENTS", 0.0f },
-            { "FORMANT_SEMITONES", -5.0f },
-            { "FORMANT_CENTS", 0.0f },
-            { "FORMANT_COMPENSATION", 1.0f },
-            { "TONALITY_HZ", 3000.0f },
-            { "FORMANT_BASE_HZ", 0.0f },
-            { "TILT_GAIN_DB", -2.0f },
-            { "TILT_CENTRE_HZ", 1000.0f },
-            { "TILT_CENTRE_AUTO", 1.0f }
-        }
-    });
-
-    presets.push_back({
-        "Chipmunk",
-        {
-            { "PITCH_SEMITONES", 12.0f },
-            { "PITCH_CENTS", 0.0f },
-            { "FORMANT_SEMITONES", 10.0f },
-            { "FORMANT_CENTS", 0.0f },
-            { "FORMANT_COMPENSATION", 0.0f },
-            { "TONALITY_HZ", 8000.0f },
-            { "FORMANT_BASE_HZ", 0.0f },
-            { "TILT_GAIN_DB", 2.0f },
-            { "TILT_CENTRE_HZ", 1000.0f },
-            { "TILT_CENTRE_AUTO", 1.0f }
-        }
-    });
-
-    presets.push_back({
-        "Deep Monster",
-        {
-            { "PITCH_SEMITONES", -12.0f },
-            { "PITCH_CENTS", 0.0f },
-            { "FORMANT_SEMITONES", -7.0f },
-            { "FORMANT_CENTS", 0.0f },
-            { "FORMANT_COMPENSATION", 1.0f },
-            { "TONALITY_HZ", 2000.0f },
-            { "FORMANT_BASE_HZ", 0.0f },
-            { "TILT_GAIN_DB", -3.0f },
-            { "TILT_CENTRE_HZ", 200.0f },
-            { "TILT_CENTRE_AUTO", 0.0f }
-        }
-    });
-
-    presets.push_back({
-        "Shimmer",
-        {
-            { "PITCH_SEMITONES", 5.0f },
-            { "PITCH_CENTS", 0.0f },
-            { "FORMANT_SEMITONES", 3.0f },
-            { "FORMANT_CENTS", 0.0f },
-            { "FORMANT_COMPENSATION", 1.0f },
-            { "TONALITY_HZ", 10000.0f },
-            { "FORMANT_BASE_HZ", 0.0f },
-            { "TILT_GAIN_DB", 4.0f },
-            { "TILT_CENTRE_HZ", 1000.0f },
-            { "TILT_CENTRE_AUTO", 1.0f }
-        }
-    });
-
-    presets.push_back({
-        "Higher Voice",
-        {
-            { "PITCH_SEMITONES", 0.0f },
-            { "PITCH_CENTS", 0.0f },
-            { "FORMANT_SEMITONES", 4.0f },
-            { "FORMANT_CENTS", 0.0f },
-            { "FORMANT_COMPENSATION", 1.0f },
-            { "TONALITY_HZ", 6000.0f },
-            { "FORMANT_BASE_HZ", 0.0f },
-            { "TILT_GAIN_DB", 1.0f },
-            { "TILT_CENTRE_HZ", 1000.0f },
-            { "TILT_CENTRE_AUTO", 1.0f }
-        }
-    });
-
-    presets.push_back({
-        "Lower Voice",
-        {
-            { "PITCH_SEMITONES", 0.0f },
-            { "PITCH_CENTS", 0.0f },
-            { "FORMANT_SEMITONES", -4.0f },
-            { "FORMANT_CENTS", 0.0f },
-            { "FORMANT_COMPENSATION", 1.0f },
-            { "TONALITY_HZ", 4000.0f },
-            { "FORMANT_BASE_HZ", 0.0f },
-            { "TILT_GAIN_DB", -1.0f },
-            { "TILT_CENTRE_HZ", 1000.0f },
-            { "TILT_CENTRE_AUTO", 1.0f }
-        }
-    });
+void PresetManager::changeListenerCallback(juce::ChangeBroadcaster*)
+{
+    loadUserPresets();
+
+    if (onPresetListChanged != nullptr)
+        onPresetListChanged();
 }
@@ -4,37 +4,61 @@
 
 #pragma once
 #include <juce_audio_processors/juce_audio_processors.h>
-#include <map>
+#include <array>
+#include <functional>
 #include <vector>
+#include "Parameters.h"
+#include "PresetLibrary.h"
 
 /**
  * Manages audio processor presets.
  *
  * Handles loading, saving, and applying parameter presets for the plugin.
- * Presets are defined as collections of parameter values that can be
- * applied to the AudioProcessorValueTreeState.
+ * Presets are flat arrays of plain parameter values indexed by Param, and
+ * are applied through parameter handles resolved once in attach(), so
+ * applying one is a single pass with no string lookups.
+ *
+ * Factory presets come first and are read straight from a constexpr table,
+ * so constructing a PresetManager builds nothing for them. They are followed
+ * by the user presets of the shared on-disk PresetLibrary, which are
+ * refreshed whenever the library changes.
  */
-class PresetManager
+class PresetManager : private juce::ChangeListener
 {
 public:
     /**
-     * Represents a single preset with a name and parameter values.
+     * A built-in preset: a compile-time name and plain parameter values.
+     */
+    struct FactoryPreset
+    {
+        const char* name;
+        std::array<float, numParams> values;   // Plain values, indexed by Param
+    };
+
+    /**
+     * Represents a single user preset with a name and parameter values.
      */
     struct Preset
     {
         juce::String name;
-        std::map<juce::String, float> values;  // paramID -> value
+        std::array<float, numParams> values {};  // Plain values, indexed by Param
+        uint32_t present = allParamBits;         // paramBit() of each value set; the rest are left unchanged
+        juce::File file;                         // Library file the preset was read from
     };
 
     /**
-     * Constructs a PresetManager and initializes factory presets.
+     * Constructs a PresetManager and lists the library's user presets.
      */
     PresetManager();
+    ~PresetManager() override;
+
+    /** Resolves the parameter handles presets are applied through. Call once the APVTS exists. */
+    void attach(juce::AudioProcessorValueTreeState& apvts);
 
     // ===== Preset Access =====
 
     /** Returns the total number of available presets. */
-    int getNumPresets() const { return static_cast<int>(presets.size()); }
+    int getNumPresets() const { return numFactoryPresets + static_cast<int>(userPresets.size()); }
 
     /** Returns the index of the currently selected preset (-1 if none). */
     int getCurrentPresetIndex() const { return currentPresetIndex; }
@@ -42,42 +66,66 @@ public:
     /** Returns the name of the preset at the given index. */
     juce::String getPresetName(int index) const;
 
-    /** Returns the preset at the given index. */
-    const Preset* getPreset(int index) const;
+    /** Returns the plain parameter values of the preset at the given index, or nullptr. */
+    const std::array<float, numParams>* getPresetValues(int index) const;
+
+    /** Returns the paramBit() of each value the preset at the given index sets, or 0. */
+    uint32_t getPresetMask(int index) const;
+
+    /** Returns the index of the user preset stored in file, or -1. */
+    int findPreset(const juce::File& file) const;
+
+    /** The shared on-disk library, e.g. for PresetLibrary::search(). */
+    PresetLibrary& getLibrary() { return *library; }
+
+    /** Called on the message thread after the preset list changed. */
+    std::function<void()> onPresetListChanged;
 
     // ===== Preset Management =====
 
     /**
-     * Applies a preset to the given APVTS.
-     * Returns true if successful, false if index is invalid.
+     * Applies a preset to the attached parameters as one batch: every changed
+     * parameter's gesture is opened, all values are set, then all gestures
+     * are closed. Returns true if successful, false if index is invalid.
      */
-    bool applyPreset(int index, const juce::AudioProcessorValueTreeState& apvts);
+    bool applyPreset(int index);
 
     /**
-     * Saves current APVTS state as a new preset.
+     * Saves the attached parameters' current values as a new user preset in
+     * the library.
      */
-    void savePreset(const juce::String& name, const juce::AudioProcessorValueTreeState& apvts);
+    void savePreset(const juce::String& name);
 
     /**
-     * Renames the preset at the given index.
+     * Renames the user preset at the given index and its library file
+     * (factory presets keep their names).
      */
     void renamePreset(int index, const juce::String& newName);
 
     /**
-     * Deletes the preset at the given index (factory presets cannot be deleted).
+     * Deletes the preset at the given index and its library file (factory
+     * presets cannot be deleted).
      */
     bool deletePreset(int index);
 
     /**
-     * Resets to factory presets.
+     * Rebuilds the list from the factory presets and the library's current contents.
      */
     void resetToFactoryPresets();
 
 private:
-    std::vector<Preset> presets;
+    static const int numFactoryPresets;  // Factory presets come first and cannot be deleted
+
+    juce::SharedResourcePointer<PresetLibrary> library;
+    std::vector<Preset> userPresets;
+    std::array<juce::RangedAudioParameter*, numParams> parameters {};
     int currentPresetIndex = -1;
-    int numFactoryPresets = 0;  // Track how many presets are factory (cannot be deleted)
 
-    /** Initializes the factory presets. */
-    void initializeFactoryPresets();
+    /** Returns the user preset at the given (overall) index, or nullptr. */
+    Preset* getUserPreset(int index);
+
+    /** Replaces the user presets with the library's current snapshot. */
+    void loadUserPresets();
+
+    void changeListenerCallback(juce::ChangeBroadcaster*) override;
 };
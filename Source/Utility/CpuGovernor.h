@@ -0,0 +1,156 @@
+//
+// Per-instance CPU budget governor
+//
+
+#pragma once
+#include <juce_core/juce_core.h>
+#include <array>
+#include <atomic>
+#include <cmath>
+
+/**
+ * Steps an instance down through quality tiers when it runs over its CPU
+ * budget, and back up once there is headroom again.
+ *
+ * Pressure is the larger of the load measurer's proportion and a decaying
+ * peak of block time / block deadline, so both sustained load and repeated
+ * worst-case blocks count. A tier change needs the pressure to stay above
+ * the budget (or below budget * hysteresis to step up) for a hold time,
+ * and is followed by a cooldown so the effect of a change is measured
+ * before the next one.
+ *
+ * Timing is accumulated from block durations rather than wall time, so the
+ * governor behaves identically in offline renders. update() runs on the
+ * audio thread; settings and the current tier are readable from any thread.
+ */
+class CpuGovernor
+{
+public:
+    enum class Tier : int
+    {
+        Full,               // Default stretch, full-rate analysis
+        CheaperStretch,     // Cheaper stretch preset
+        ReducedAnalysis,    // ...and the spectral centroid at a quarter of its rate
+        AnalysisOff,        // ...and centroid/pitch tracking frozen at their last values
+        NumTiers
+    };
+
+    static constexpr int numTiers = static_cast<int>(Tier::NumTiers);
+
+    static const char* getTierName(Tier tier)
+    {
+        static constexpr std::array<const char*, numTiers> names {
+            "Full", "Cheaper stretch", "Reduced analysis", "Analysis off"
+        };
+        return names[static_cast<size_t>(tier)];
+    }
+
+    void setEnabled(bool shouldBeEnabled) noexcept { enabled.store(shouldBeEnabled, std::memory_order_relaxed); }
+    bool isEnabled() const noexcept { return enabled.load(std::memory_order_relaxed); }
+
+    /** Budget as a fraction of each block's real-time deadline (0.1..1). */
+    void setBudget(float fraction) noexcept { budget.store(juce::jlimit(0.1f, 1.0f, fraction), std::memory_order_relaxed); }
+    float getBudget() const noexcept { return budget.load(std::memory_order_relaxed); }
+
+    Tier getTier() const noexcept { return tier.load(std::memory_order_relaxed); }
+
+    /** Pressure seen by the last update(), for display and logging. */
+    float getPressure() const noexcept { return pressure.load(std::memory_order_relaxed); }
+
+    /** Audio thread: clears the measurement state (the tier is kept). */
+    void reset() noexcept
+    {
+        peakRatio = 0.0f;
+        overMs = 0.0f;
+        underMs = 0.0f;
+        cooldownMs = cooldownAfterChangeMs;
+    }
+
+    /**
+     * Audio thread: feeds one block's measurements. Returns true when the
+     * tier changed; previousTier then holds the tier that was replaced.
+     */
+    bool update(float load, float blockMs, float deadlineMs, Tier& previousTier) noexcept
+    {
+        previousTier = getTier();
+
+        if (! isEnabled())
+        {
+            reset();
+            return setTier(Tier::Full);
+        }
+
+        if (deadlineMs <= 0.0f)
+            return false;
+
+        // Decaying peak of the worst block over roughly peakWindowMs
+        const float ratio = blockMs / deadlineMs;
+        peakRatio = juce::jmax(ratio, peakRatio * std::exp(-deadlineMs / peakWindowMs));
+
+        const float currentPressure = juce::jmax(load, peakRatio);
+        pressure.store(currentPressure, std::memory_order_relaxed);
+
+        if (cooldownMs > 0.0f)
+        {
+            cooldownMs -= deadlineMs;
+            return false;
+        }
+
+        const float limit = getBudget();
+        if (currentPressure > limit)
+        {
+            overMs += deadlineMs;
+            underMs = 0.0f;
+        }
+        else if (currentPressure < limit * hysteresis)
+        {
+            underMs += deadlineMs;
+            overMs = 0.0f;
+        }
+        else
+        {
+            overMs = 0.0f;
+            underMs = 0.0f;
+        }
+
+        const int current = static_cast<int>(previousTier);
+
+        if (overMs >= stepDownHoldMs && current < numTiers - 1)
+            return setTier(static_cast<Tier>(current + 1));
+
+        if (underMs >= stepUpHoldMs && current > 0)
+            return setTier(static_cast<Tier>(current - 1));
+
+        return false;
+    }
+
+private:
+    static constexpr float peakWindowMs = 250.0f;
+    static constexpr float stepDownHoldMs = 500.0f;
+    static constexpr float stepUpHoldMs = 4000.0f;
+    static constexpr float cooldownAfterChangeMs = 1000.0f;
+    static constexpr float hysteresis = 0.6f;   // Step up only below 60% of the budget
+
+    std::atomic<bool> enabled { false };
+    std::atomic<float> budget { 0.75f };
+    std::atomic<Tier> tier { Tier::Full };
+    std::atomic<float> pressure { 0.0f };
+
+    // Audio thread only
+    float peakRatio = 0.0f;
+    float overMs = 0.0f;
+    float underMs = 0.0f;
+    float cooldownMs = 0.0f;
+
+    bool setTier(Tier newTier) noexcept
+    {
+        if (newTier == getTier())
+            return false;
+
+        tier.store(newTier, std::memory_order_relaxed);
+        overMs = 0.0f;
+        underMs = 0.0f;
+        cooldownMs = cooldownAfterChangeMs;
+        return true;
+    }
+};
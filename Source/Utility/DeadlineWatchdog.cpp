@@ -0,0 +1,197 @@
+//
+// Deadline-overrun watchdog
+//
+
+#include "DeadlineWatchdog.h"
+#include "Tracing.h"
+
+namespace
+{
+    std::atomic<int> nextInstanceId { 1 };
+}
+
+DeadlineWatchdog::DeadlineWatchdog()
+    : instanceId (nextInstanceId.fetch_add (1, std::memory_order_relaxed)),
+      logDirectory (getDefaultLogDirectory())
+{
+}
+
+DeadlineWatchdog::~DeadlineWatchdog()
+{
+    flush();
+}
+
+bool DeadlineWatchdog::report (float blockMs, float deadlineMs, int blockSize, double sampleRate,
+                               const std::array<float, numParams>& params, const StageProfiler& profiler,
+                               uint64_t flowId) noexcept
+{
+    if (deadlineMs <= 0.0f || blockMs < deadlineMs * thresholdFraction.load (std::memory_order_relaxed))
+        return false;
+
+    const auto scope = fifo.write (1);
+    if (scope.blockSize1 == 0)
+    {
+        dropped.fetch_add (1, std::memory_order_relaxed);
+        return false;
+    }
+
+    auto& record = ring[static_cast<size_t> (scope.startIndex1)];
+    record.timestampMs = juce::Time::currentTimeMillis();
+    record.blockSize = blockSize;
+    record.sampleRate = static_cast<float> (sampleRate);
+    record.blockMs = blockMs;
+    record.deadlineMs = deadlineMs;
+    record.params = params;
+    record.flowId = flowId;
+
+    for (int i = 0; i < StageProfiler::numStages; ++i)
+        record.stageMs[static_cast<size_t> (i)] = static_cast<float> (profiler.getBlockMs (static_cast<StageProfiler::Stage> (i)));
+
+    return true;
+}
+
+void DeadlineWatchdog::reportQualityChange (const char* fromTier, const char* toTier, float pressure) noexcept
+{
+    const auto scope = qualityFifo.write (1);
+    if (scope.blockSize1 == 0)
+    {
+        dropped.fetch_add (1, std::memory_order_relaxed);
+        return;
+    }
+
+    qualityRing[static_cast<size_t> (scope.startIndex1)] = { juce::Time::currentTimeMillis(), fromTier, toTier, pressure };
+}
+
+int DeadlineWatchdog::useTimeSlice()
+{
+    flush();
+    return 500;
+}
+
+void DeadlineWatchdog::flush()
+{
+    const juce::ScopedLock sl (writeLock);
+
+    const int numReady = fifo.getNumReady();
+    const int numQualityChanges = qualityFifo.getNumReady();
+    if (numReady == 0 && numQualityChanges == 0)
+        return;
+
+    const auto logFile = getLogFile();
+    rotateIfNeeded (logFile);
+
+    juce::FileOutputStream stream (logFile);
+    const bool canWrite = stream.openedOk();
+
+    const auto scope = fifo.read (numReady);
+    auto writeRange = [&] (int start, int size)
+    {
+        for (int i = 0; i < size; ++i)
+        {
+            const auto& record = ring[static_cast<size_t> (start + i)];
+
+           #if PERFETTO
+            TRACE_EVENT ("dsp", "watchdog-write", perfetto::TerminatingFlow::ProcessScoped (record.flowId));
+           #endif
+
+            if (canWrite)
+                stream << toJson (record) << "\n";
+        }
+    };
+
+    writeRange (scope.startIndex1, scope.blockSize1);
+    writeRange (scope.startIndex2, scope.blockSize2);
+
+    const auto qualityScope = qualityFifo.read (numQualityChanges);
+    auto writeQualityRange = [&] (int start, int size)
+    {
+        for (int i = 0; i < size; ++i)
+        {
+            const auto& change = qualityRing[static_cast<size_t> (start + i)];
+
+            if (canWrite)
+                stream << toJson (change) << "\n";
+        }
+    };
+
+    writeQualityRange (qualityScope.startIndex1, qualityScope.blockSize1);
+    writeQualityRange (qualityScope.startIndex2, qualityScope.blockSize2);
+
+    if (canWrite)
+        stream.flush();
+}
+
+juce::File DeadlineWatchdog::getDefaultLogDirectory()
+{
+    return juce::File::getSpecialLocation (juce::File::userApplicationDataDirectory)
+        .getChildFile ("trencrumb")
+        .getChildFile ("Spectral Shift")
+        .getChildFile ("Logs");
+}
+
+juce::File DeadlineWatchdog::getLogFile() const
+{
+    logDirectory.createDirectory();
+    return logDirectory.getChildFile ("watchdog.jsonl");
+}
+
+void DeadlineWatchdog::rotateIfNeeded (const juce::File& logFile) const
+{
+    if (logFile.getSize() < maxLogBytes)
+        return;
+
+    // watchdog.jsonl -> watchdog.1.jsonl -> ... -> watchdog.N.jsonl (oldest dropped)
+    auto rotated = [this] (int index)
+    {
+        return logDirectory.getChildFile ("watchdog." + juce::String (index) + ".jsonl");
+    };
+
+    rotated (numRotatedLogs).deleteFile();
+    for (int i = numRotatedLogs - 1; i >= 1; --i)
+        rotated (i).moveFileTo (rotated (i + 1));
+
+    logFile.moveFileTo (rotated (1));
+}
+
+juce::String DeadlineWatchdog::toJson (const Record& record) const
+{
+    auto* object = new juce::DynamicObject();
+    object->setProperty ("time", juce::Time (record.timestampMs).toISO8601 (true));
+    object->setProperty ("instance", instanceId);
+    object->setProperty ("blockSize", record.blockSize);
+    object->setProperty ("sampleRate", finiteOrNull (record.sampleRate));
+    object->setProperty ("blockMs", finiteOrNull (record.blockMs));
+    object->setProperty ("deadlineMs", finiteOrNull (record.deadlineMs));
+
+    auto* params = new juce::DynamicObject();
+    for (int i = 0; i < numParams; ++i)
+        params->setProperty (paramIDs[static_cast<size_t> (i)], finiteOrNull (record.params[static_cast<size_t> (i)]));
+    object->setProperty ("params", juce::var (params));
+
+    auto* stages = new juce::DynamicObject();
+    for (int i = 0; i < StageProfiler::numStages; ++i)
+        stages->setProperty (StageProfiler::getStageName (static_cast<StageProfiler::Stage> (i)),
+                             finiteOrNull (record.stageMs[static_cast<size_t> (i)]));
+    object->setProperty ("stageMs", juce::var (stages));
+
+    return juce::JSON::toString (juce::var (object), true);
+}
+
+juce::String DeadlineWatchdog::toJson (const QualityChange& change) const
+{
+    auto* object = new juce::DynamicObject();
+    object->setProperty ("time", juce::Time (change.timestampMs).toISO8601 (true));
+    object->setProperty ("instance", instanceId);
+    object->setProperty ("event", "quality-change");
+    object->setProperty ("from", change.fromTier);
+    object->setProperty ("to", change.toTier);
+    object->setProperty ("pressure", finiteOrNull (change.pressure));
+
+    return juce::JSON::toString (juce::var (object), true);
+}
+
+juce::var DeadlineWatchdog::finiteOrNull (float value)
+{
+    // JSON has no NaN or infinity; a void var is written as null
+    return std::isfinite (value) ? juce::var (value) : juce::var();
+}
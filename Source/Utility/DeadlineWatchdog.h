@@ -0,0 +1,114 @@
+//
+// Deadline-overrun watchdog
+//
+
+#pragma once
+#include <juce_core/juce_core.h>
+#include <array>
+#include <atomic>
+#include "../Parameters.h"
+#include "StageProfiler.h"
+
+/**
+ * Captures context for blocks that run close to (or past) their deadline.
+ *
+ * The audio thread calls report() once per block. When the processing time
+ * exceeds a configurable fraction of the block's real-time duration, a
+ * compact record (timestamp, block size, parameter snapshot and the time
+ * each stage took in that block) is copied into a preallocated lock-free ring. Nothing is allocated
+ * and no file IO happens on the audio thread.
+ *
+ * As a TimeSliceClient, the watchdog drains the ring on a background thread
+ * and appends one JSON object per line to a log file in the user data
+ * directory. The log is flushed after every batch and rotated at 1 MB.
+ * Quality tier changes made by the CPU governor are logged the same way.
+ * Every line carries the watchdog's instance id, since all instances share
+ * the log, and non-finite values are written as null to keep it valid JSON.
+ */
+class DeadlineWatchdog : public juce::TimeSliceClient
+{
+public:
+    struct Record
+    {
+        juce::int64 timestampMs = 0;
+        int blockSize = 0;
+        float sampleRate = 0.0f;
+        float blockMs = 0.0f;
+        float deadlineMs = 0.0f;
+        std::array<float, numParams> params {};
+        std::array<float, StageProfiler::numStages> stageMs {};  // 0 for stages that didn't run in the block
+        uint64_t flowId = 0;  // Perfetto flow from the audio block to the log write (0 = none)
+    };
+
+    DeadlineWatchdog();
+    ~DeadlineWatchdog() override;
+
+    /** Fraction of the block deadline above which a block is logged (default 0.8). */
+    void setThresholdFraction (float fraction) noexcept { thresholdFraction.store (fraction, std::memory_order_relaxed); }
+    float getThresholdFraction() const noexcept { return thresholdFraction.load (std::memory_order_relaxed); }
+
+    /** Overrides the log directory (defaults to the user data directory). Call before logging starts. */
+    void setLogDirectory (const juce::File& directory) { logDirectory = directory; }
+
+    /**
+     * Audio thread: checks the block against the threshold and queues a record
+     * if it is exceeded. Returns true if a record was queued.
+     */
+    bool report (float blockMs, float deadlineMs, int blockSize, double sampleRate,
+                 const std::array<float, numParams>& params, const StageProfiler& profiler,
+                 uint64_t flowId = 0) noexcept;
+
+    /** Audio thread: logs a quality tier change (tier names must be string literals). */
+    void reportQualityChange (const char* fromTier, const char* toTier, float pressure) noexcept;
+
+    /** Process-unique id written with every log line, to tell instances apart. */
+    int getInstanceId() const noexcept { return instanceId; }
+
+    /** Any thread: number of records waiting to be written. */
+    int getNumQueued() const noexcept { return fifo.getNumReady(); }
+
+    /** Number of records dropped because the ring was full. */
+    int getNumDropped() const noexcept { return dropped.load (std::memory_order_relaxed); }
+
+    /** Background thread: writes queued records to the log. */
+    int useTimeSlice() override;
+
+    /** Writes any queued records immediately (not real-time safe). */
+    void flush();
+
+    static juce::File getDefaultLogDirectory();
+
+private:
+    static constexpr int capacity = 32;
+    static constexpr juce::int64 maxLogBytes = 1024 * 1024;
+    static constexpr int numRotatedLogs = 3;
+
+    struct QualityChange
+    {
+        juce::int64 timestampMs = 0;
+        const char* fromTier = "";
+        const char* toTier = "";
+        float pressure = 0.0f;
+    };
+
+    juce::AbstractFifo fifo { capacity };
+    std::array<Record, capacity> ring {};
+
+    static constexpr int qualityChangeCapacity = 16;
+    juce::AbstractFifo qualityFifo { qualityChangeCapacity };
+    std::array<QualityChange, qualityChangeCapacity> qualityRing {};
+    std::atomic<float> thresholdFraction { 0.8f };
+    std::atomic<int> dropped { 0 };
+
+    const int instanceId;
+    juce::File logDirectory;
+    juce::CriticalSection writeLock;  // Serialises flush() against the background thread
+
+    juce::File getLogFile() const;
+    void rotateIfNeeded (const juce::File& logFile) const;
+    juce::String toJson (const Record& record) const;
+    juce::String toJson (const QualityChange& change) const;
+    static juce::var finiteOrNull (float value);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (DeadlineWatchdog)
+};
@@ -0,0 +1,37 @@
+//
+// Prefaulted arena for per-instance DSP memory
+//
+
+#include "DspArena.h"
+
+#if JUCE_WINDOWS
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #include <windows.h>
+#else
+    #include <sys/mman.h>
+#endif
+
+void DspArena::lock()
+{
+    // Best effort: fails quietly when the process has no lock allowance
+   #if JUCE_WINDOWS
+    locked = VirtualLock(base, capacity) != 0;
+   #else
+    locked = mlock(base, capacity) == 0;
+   #endif
+}
+
+void DspArena::unlock()
+{
+    if (! locked)
+        return;
+
+   #if JUCE_WINDOWS
+    VirtualUnlock(base, capacity);
+   #else
+    munlock(base, capacity);
+   #endif
+    locked = false;
+}
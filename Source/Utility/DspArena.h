@@ -0,0 +1,120 @@
+//
+// Prefaulted arena for per-instance DSP memory
+//
+
+#pragma once
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+/**
+ * One contiguous, 64-byte aligned block holding an instance's DSP buffers.
+ *
+ * prepareToPlay() sizes the arena from the components' getArenaBytes()
+ * queries, then each component carves its buffers out of it with
+ * allocate() / allocateBuffer(). Every page is written when the arena is
+ * prepared (and locked into RAM where the OS permits), so the first block
+ * after a transport start doesn't pay for page faults.
+ *
+ * Only trivially constructible types (floats, pointers) may be allocated;
+ * memory is zeroed, never constructed or destroyed. Everything handed out
+ * is invalidated by the next prepare().
+ */
+class DspArena
+{
+public:
+    static constexpr size_t alignment = 64;
+
+    DspArena() = default;
+    ~DspArena() { unlock(); }
+
+    /** Bytes needed for count objects of T, including alignment padding. */
+    template <typename T>
+    static constexpr size_t bytesFor(size_t count)
+    {
+        return (sizeof(T) * count + alignment - 1) & ~(alignment - 1);
+    }
+
+    /** Bytes needed for an AudioBuffer made by allocateBuffer(). */
+    static constexpr size_t bytesForBuffer(int numChannels, int numSamples)
+    {
+        return static_cast<size_t>(numChannels) * bytesFor<float>(static_cast<size_t>(numSamples));
+    }
+
+    /**
+     * Message thread: makes room for capacityBytes, zeroes (prefaults) all of
+     * it and rewinds. Reuses the existing block when it is already big enough.
+     */
+    void prepare(size_t capacityBytes, bool lockPages)
+    {
+        unlock();
+
+        if (capacityBytes > capacity)
+        {
+            storage.reset(new char[capacityBytes + alignment]);
+            capacity = capacityBytes;
+        }
+
+        const auto address = reinterpret_cast<uintptr_t>(storage.get());
+        base = reinterpret_cast<char*>((address + alignment - 1) & ~(alignment - 1));
+        used = 0;
+        overflow.clear();
+
+        // Touch every page so the audio thread never faults on first use
+        if (capacity > 0)
+            std::memset(base, 0, capacity);
+
+        if (lockPages && capacity > 0)
+            lock();
+    }
+
+    /** Returns zeroed, aligned storage for count objects of T. */
+    template <typename T>
+    T* allocate(size_t count)
+    {
+        static_assert(std::is_trivially_default_constructible_v<T> && std::is_trivially_destructible_v<T>);
+
+        const size_t bytes = bytesFor<T>(juce::jmax(size_t { 1 }, count));
+
+        if (used + bytes > capacity)
+        {
+            // A component asked for more than its getArenaBytes() reported; stay safe in release builds
+            jassertfalse;
+            overflow.emplace_back(new char[bytes + alignment]());
+            const auto address = reinterpret_cast<uintptr_t>(overflow.back().get());
+            return reinterpret_cast<T*>((address + alignment - 1) & ~(alignment - 1));
+        }
+
+        auto* result = reinterpret_cast<T*>(base + used);
+        used += bytes;
+        return result;
+    }
+
+    /** Points buffer at numChannels x numSamples of arena memory (no allocation on later use). */
+    void allocateBuffer(juce::AudioBuffer<float>& buffer, int numChannels, int numSamples)
+    {
+        std::vector<float*> channels(static_cast<size_t>(numChannels));
+        for (auto& channel : channels)
+            channel = allocate<float>(static_cast<size_t>(numSamples));
+
+        buffer.setDataToReferTo(channels.data(), numChannels, numSamples);
+    }
+
+    size_t getCapacity() const { return capacity; }
+    size_t getBytesUsed() const { return used; }
+    bool isLocked() const { return locked; }
+
+private:
+    std::unique_ptr<char[]> storage;
+    std::vector<std::unique_ptr<char[]>> overflow;
+    char* base = nullptr;
+    size_t capacity = 0;
+    size_t used = 0;
+    bool locked = false;
+
+    void lock();
+    void unlock();
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (DspArena)
+};
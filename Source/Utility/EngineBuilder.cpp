@@ -0,0 +1,116 @@
+//
+// Background construction and lock-free hand-off of stretch engines
+//
+
+#include "EngineBuilder.h"
+
+EngineBuilder::EngineBuilder (SharedResources& resources)
+    : juce::ThreadPoolJob ("SpectralShift engine build"),
+      shared (resources)
+{
+}
+
+EngineBuilder::~EngineBuilder()
+{
+    {
+        const juce::ScopedLock sl (dispatchLock);
+        if (hasDispatched)
+            shared.getWorkerPool().removeJob (this, true, -1);
+    }
+
+    discardReady();
+}
+
+void EngineBuilder::prepare (int numChannels, double sampleRate, int maxBlockSize, int targetLatency)
+{
+    const juce::ScopedLock sl (dispatchLock);
+
+    // A build in flight would finish with the old settings
+    if (hasDispatched)
+        shared.getWorkerPool().waitForJobToFinish (this, -1);
+
+    channels = numChannels;
+    rate = sampleRate;
+    blockSize = maxBlockSize;
+    latency = targetLatency;
+
+    discardReady();
+    dispatchedSerial = requestSerial.load (std::memory_order_relaxed);
+    prepared.store (true, std::memory_order_release);
+}
+
+void EngineBuilder::request (StretchEngine::Quality quality) noexcept
+{
+    requestedQuality.store (static_cast<int> (quality), std::memory_order_relaxed);
+    requestSerial.fetch_add (1, std::memory_order_release);
+}
+
+std::unique_ptr<StretchEngine> EngineBuilder::takeReady() noexcept
+{
+    return std::unique_ptr<StretchEngine> (ready.exchange (nullptr, std::memory_order_acq_rel));
+}
+
+bool EngineBuilder::retire (std::unique_ptr<StretchEngine>& engine) noexcept
+{
+    return engine == nullptr || retired.push (engine);
+}
+
+std::unique_ptr<StretchEngine> EngineBuilder::build (StretchEngine::Quality quality) const
+{
+    auto engine = std::make_unique<StretchEngine>();
+    engine->configure (channels, rate, blockSize, quality);
+
+    // The target is the largest latency of any preset, so alignment only ever adds delay
+    jassert (engine->getEngineLatency() <= latency);
+    engine->alignTo (latency);
+    engine->warmUp();
+    return engine;
+}
+
+int EngineBuilder::useTimeSlice()
+{
+    deleteRetired();
+
+    if (! prepared.load (std::memory_order_acquire))
+        return 100;
+
+    const auto serial = requestSerial.load (std::memory_order_acquire);
+    const juce::ScopedLock sl (dispatchLock);
+
+    if (serial != dispatchedSerial)
+    {
+        auto& pool = shared.getWorkerPool();
+
+        // A running build picks up the newest request when it is dispatched again afterwards
+        if (! pool.contains (this))
+        {
+            dispatchedSerial = serial;
+            hasDispatched = true;
+            pool.addJob (this, false);
+        }
+    }
+
+    return 20;
+}
+
+juce::ThreadPoolJob::JobStatus EngineBuilder::runJob()
+{
+    const auto quality = static_cast<StretchEngine::Quality> (requestedQuality.load (std::memory_order_relaxed));
+    auto engine = build (quality);
+
+    // An engine the audio thread never picked up is simply replaced
+    delete ready.exchange (engine.release(), std::memory_order_acq_rel);
+    return jobHasFinished;
+}
+
+void EngineBuilder::deleteRetired()
+{
+    std::unique_ptr<StretchEngine> engine;
+    while (retired.pop (engine))
+        engine.reset();
+}
+
+void EngineBuilder::discardReady()
+{
+    delete ready.exchange (nullptr, std::memory_order_acq_rel);
+}
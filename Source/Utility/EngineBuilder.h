@@ -0,0 +1,86 @@
+//
+// Background construction and lock-free hand-off of stretch engines
+//
+
+#pragma once
+#include <juce_core/juce_core.h>
+#include <array>
+#include <atomic>
+#include <memory>
+#include "../DSP/StretchEngine.h"
+#include "SharedResources.h"
+#include "SpscQueue.h"
+
+/**
+ * Builds replacement StretchEngines off the audio thread and hands them over
+ * without locks or allocation.
+ *
+ * The audio thread asks for an engine with request(). The shared IO thread
+ * notices the request and queues a build on the shared worker pool, which
+ * configures, aligns and warms up a new engine and publishes it through an
+ * atomic pointer. The audio thread picks it up with takeReady(), primes it
+ * and crossfades it in, then hands the engine it replaced to retire(). The
+ * IO thread deletes retired engines, so no engine is freed on the audio
+ * thread.
+ *
+ * prepare() must be called with audio stopped; it waits for any build in
+ * progress and discards engines built for the previous configuration.
+ */
+class EngineBuilder : public juce::TimeSliceClient,
+                      private juce::ThreadPoolJob
+{
+public:
+    explicit EngineBuilder (SharedResources& resources);
+    ~EngineBuilder() override;
+
+    /** Message thread, audio stopped: settings for every engine built from now on. */
+    void prepare (int numChannels, double sampleRate, int maxBlockSize, int targetLatency);
+
+    /** Audio thread: asks for an engine of the given quality (replaces any earlier request). */
+    void request (StretchEngine::Quality quality) noexcept;
+
+    /** Audio thread: the most recently built engine, or nullptr if none is ready. */
+    std::unique_ptr<StretchEngine> takeReady() noexcept;
+
+    /**
+     * Audio thread: queues an engine for deletion on the IO thread. Returns
+     * false (leaving the engine with the caller) when the queue is full.
+     */
+    bool retire (std::unique_ptr<StretchEngine>& engine) noexcept;
+
+    /** Builds an engine on the calling thread with the prepared settings (allocates). */
+    std::unique_ptr<StretchEngine> build (StretchEngine::Quality quality) const;
+
+    /** IO thread: deletes retired engines and starts requested builds. */
+    int useTimeSlice() override;
+
+private:
+    static constexpr int retiredCapacity = 8;
+
+    SharedResources& shared;
+
+    // Written by prepare() only while no build is running
+    int channels = 0;
+    double rate = 0.0;
+    int blockSize = 0;
+    int latency = 0;
+
+    juce::CriticalSection dispatchLock;
+    std::atomic<bool> prepared { false };
+
+    std::atomic<int> requestedQuality { 0 };
+    std::atomic<uint32_t> requestSerial { 0 };
+    uint32_t dispatchedSerial = 0;    // Under dispatchLock
+    bool hasDispatched = false;       // Under dispatchLock; the pool is only touched once a build was queued
+
+    std::atomic<StretchEngine*> ready { nullptr };
+
+    // Return queue: engines the audio thread is done with, deleted on the IO thread
+    SpscQueue<std::unique_ptr<StretchEngine>, retiredCapacity> retired;
+
+    JobStatus runJob() override;
+    void deleteRetired();
+    void discardReady();
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (EngineBuilder)
+};
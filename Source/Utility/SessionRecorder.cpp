@@ -0,0 +1,218 @@
+//
+// Session trace recorder and reader
+//
+
+#include "SessionRecorder.h"
+#include <thread>
+
+//==============================================================================
+void SessionTrace::writeHeader (juce::OutputStream& out, const Header& header)
+{
+    out.writeInt (magic);
+    out.writeInt (version);
+    out.writeDouble (header.sampleRate);
+    out.writeInt (header.numChannels);
+    out.writeInt (header.maxBlockSize);
+    out.writeInt (header.numParams);
+    out.writeInt (header.hasAudio ? flagHasAudio : 0);
+}
+
+bool SessionTrace::readHeader (juce::InputStream& in, Header& header)
+{
+    if (in.readInt() != magic || in.readInt() != version)
+        return false;
+
+    header.sampleRate = in.readDouble();
+    header.numChannels = in.readInt();
+    header.maxBlockSize = in.readInt();
+    header.numParams = in.readInt();
+    header.hasAudio = (in.readInt() & flagHasAudio) != 0;
+
+    return ! in.isExhausted()
+        && header.sampleRate > 0.0
+        && header.numChannels > 0
+        && header.maxBlockSize > 0
+        && header.numParams == numParams;
+}
+
+bool SessionTrace::readBlock (juce::InputStream& in, const Header& header, int& numSamples,
+                              std::array<float, numParams>& params, juce::AudioBuffer<float>& audio)
+{
+    if (in.getNumBytesRemaining() < static_cast<juce::int64> (sizeof (int) + sizeof (float) * numParams))
+        return false;
+
+    numSamples = in.readInt();
+    if (numSamples < 0)
+        return false;
+
+    for (auto& value : params)
+        value = in.readFloat();
+
+    audio.setSize (header.numChannels, numSamples, false, false, true);
+
+    if (! header.hasAudio)
+    {
+        audio.clear();
+        return true;
+    }
+
+    const auto audioBytes = sizeof (float) * static_cast<size_t> (numSamples);
+    for (int ch = 0; ch < header.numChannels; ++ch)
+        if (in.read (audio.getWritePointer (ch), static_cast<int> (audioBytes)) != static_cast<int> (audioBytes))
+            return false;
+
+    return true;
+}
+
+//==============================================================================
+SessionRecorder::~SessionRecorder()
+{
+    stop();
+}
+
+bool SessionRecorder::start (const juce::File& file, bool includeAudio, double sampleRate, int numChannels, int maxBlockSize)
+{
+    stop();
+
+    if (sampleRate <= 0.0 || numChannels <= 0 || maxBlockSize <= 0)
+        return false;
+
+    auto newStream = std::make_unique<juce::FileOutputStream> (file);
+    if (! newStream->openedOk())
+        return false;
+
+    newStream->setPosition (0);
+    newStream->truncate();
+
+    header = { sampleRate, numChannels, maxBlockSize, numParams, includeAudio };
+    SessionTrace::writeHeader (*newStream, header);
+
+    // stop() has waited out any captureBlock in flight, so nothing writes to the ring here.
+    // Allocated on first use only; the audio thread never sees the ring resize
+    if (storage.empty())
+    {
+        storage.resize (static_cast<size_t> (ringBytes));
+        fifo.setTotalSize (ringBytes);
+    }
+    silence.assign (static_cast<size_t> (maxBlockSize), 0.0f);
+
+    {
+        // The reset happens under the stream lock, so drain() can't read the ring meanwhile
+        const juce::ScopedLock sl (streamLock);
+        fifo.reset();
+        stream = std::move (newStream);
+    }
+
+    // Arms capture; the release store publishes the reset ring and header to captureBlock
+    overflowed.store (false, std::memory_order_relaxed);
+    capturing.store (true, std::memory_order_release);
+    return true;
+}
+
+void SessionRecorder::stop()
+{
+    capturing.store (false, std::memory_order_seq_cst);
+
+    // A block that saw capturing before the store above may still be copying; wait it out
+    // (at most one block's memcpy) so the ring has no writer once this returns
+    while (writing.load (std::memory_order_seq_cst))
+        std::this_thread::yield();
+
+    const juce::ScopedLock sl (streamLock);
+    drain();
+    stream.reset();
+}
+
+void SessionRecorder::captureBlock (const juce::AudioBuffer<float>& buffer, int numSamples,
+                                    const std::array<float, numParams>& params) noexcept
+{
+    if (! capturing.load (std::memory_order_acquire))
+        return;
+
+    // Announce the write, then check again: paired with stop(), either stop() sees this
+    // flag and waits, or this block sees capture disarmed and leaves the ring alone
+    struct WriteScope
+    {
+        std::atomic<bool>& flag;
+        ~WriteScope() { flag.store (false, std::memory_order_release); }
+    };
+
+    writing.store (true, std::memory_order_seq_cst);
+    const WriteScope writeScope { writing };
+
+    if (! capturing.load (std::memory_order_seq_cst))
+        return;
+
+    const auto audioBytes = header.hasAudio ? sizeof (float) * static_cast<size_t> (numSamples * header.numChannels) : 0;
+    const auto blockBytes = sizeof (int) + sizeof (float) * numParams + audioBytes;
+
+    if (static_cast<size_t> (fifo.getFreeSpace()) < blockBytes)
+    {
+        overflowed.store (true, std::memory_order_relaxed);
+        capturing.store (false, std::memory_order_release);
+        return;
+    }
+
+    const auto scope = fifo.write (static_cast<int> (blockBytes));
+    size_t position = 0;
+
+    // Copies into the (possibly wrapped) region reserved for this block
+    auto push = [&] (const void* data, size_t numBytes)
+    {
+        const auto* src = static_cast<const char*> (data);
+        const auto first = juce::jmin (numBytes, static_cast<size_t> (scope.blockSize1) - juce::jmin (position, static_cast<size_t> (scope.blockSize1)));
+
+        if (first > 0)
+            std::memcpy (storage.data() + scope.startIndex1 + position, src, first);
+        if (numBytes > first)
+            std::memcpy (storage.data() + scope.startIndex2 + (position + first - static_cast<size_t> (scope.blockSize1)),
+                         src + first, numBytes - first);
+
+        position += numBytes;
+    };
+
+    // Raw native floats; every supported platform is little endian, like the reader's streams
+    push (&numSamples, sizeof (int));
+    push (params.data(), sizeof (float) * numParams);
+
+    if (header.hasAudio)
+    {
+        for (int ch = 0; ch < header.numChannels; ++ch)
+        {
+            if (ch < buffer.getNumChannels())
+            {
+                push (buffer.getReadPointer (ch), sizeof (float) * static_cast<size_t> (numSamples));
+                continue;
+            }
+
+            for (int done = 0; done < numSamples;)
+            {
+                const int chunk = juce::jmin (numSamples - done, static_cast<int> (silence.size()));
+                push (silence.data(), sizeof (float) * static_cast<size_t> (chunk));
+                done += chunk;
+            }
+        }
+    }
+}
+
+int SessionRecorder::useTimeSlice()
+{
+    const juce::ScopedLock sl (streamLock);
+    drain();
+    return isRecording() ? 20 : 250;
+}
+
+void SessionRecorder::drain()
+{
+    if (stream == nullptr)
+        return;
+
+    const auto scope = fifo.read (fifo.getNumReady());
+
+    if (scope.blockSize1 > 0)
+        stream->write (storage.data() + scope.startIndex1, static_cast<size_t> (scope.blockSize1));
+    if (scope.blockSize2 > 0)
+        stream->write (storage.data() + scope.startIndex2, static_cast<size_t> (scope.blockSize2));
+
+    stream->flush();
+}
@@ -0,0 +1,110 @@
+//
+// Session trace recorder and reader
+//
+
+#pragma once
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <array>
+#include <atomic>
+#include "../Parameters.h"
+
+/**
+ * Compact binary trace of the block sequence a host delivered.
+ *
+ * Layout (little endian):
+ *   header: magic "SSTR", version, sample rate (double), channels, max block
+ *           size, parameter count, flags (bit 0: audio included)
+ *   blocks: numSamples (int32), parameter values (float x parameter count),
+ *           then channel-major input audio (float x channels x numSamples)
+ *           when the audio flag is set
+ *
+ * Parameter values are plain (denormalised) values in Param order.
+ */
+namespace SessionTrace
+{
+    inline constexpr int magic = 0x52545353;  // "SSTR"
+    inline constexpr int version = 1;
+    inline constexpr int flagHasAudio = 1;
+
+    struct Header
+    {
+        double sampleRate = 0.0;
+        int numChannels = 0;
+        int maxBlockSize = 0;
+        int numParams = 0;
+        bool hasAudio = false;
+    };
+
+    void writeHeader (juce::OutputStream& out, const Header& header);
+
+    /** Reads and validates a header. Returns false for anything that isn't a compatible trace. */
+    bool readHeader (juce::InputStream& in, Header& header);
+
+    /**
+     * Reads the next block. Returns false at the end of the trace (including a
+     * truncated final block). audio is resized to the header's channel count;
+     * it is cleared when the trace has no audio.
+     */
+    bool readBlock (juce::InputStream& in, const Header& header, int& numSamples,
+                    std::array<float, numParams>& params, juce::AudioBuffer<float>& audio);
+}
+
+/**
+ * Records host block sizes, parameter snapshots and optionally the input
+ * audio into a SessionTrace file, for deterministic offline replay.
+ *
+ * The audio thread only copies bytes into a preallocated lock-free ring; as a
+ * TimeSliceClient the recorder drains that ring to disk on a background
+ * thread. If the ring fills up (the writer fell behind) capture stops rather
+ * than silently leaving a gap, since a trace with missing blocks no longer
+ * reproduces the session.
+ */
+class SessionRecorder : public juce::TimeSliceClient
+{
+public:
+    SessionRecorder() = default;
+    ~SessionRecorder() override;
+
+    /** Message thread: opens the file, writes the header and starts capturing. */
+    bool start (const juce::File& file, bool includeAudio, double sampleRate, int numChannels, int maxBlockSize);
+
+    /**
+     * Message thread: stops capturing and writes out everything still queued.
+     * Waits for a captureBlock() already in progress to finish.
+     */
+    void stop();
+
+    bool isRecording() const noexcept { return capturing.load (std::memory_order_acquire); }
+
+    /** True if the last recording stopped early because the ring overflowed. */
+    bool hasOverflowed() const noexcept { return overflowed.load (std::memory_order_relaxed); }
+
+    /** Any thread: bytes captured but not yet written to disk. */
+    int getNumQueuedBytes() const noexcept { return fifo.getNumReady(); }
+
+    /** Audio thread: appends one block to the trace. Call before the buffer is processed. */
+    void captureBlock (const juce::AudioBuffer<float>& buffer, int numSamples,
+                       const std::array<float, numParams>& params) noexcept;
+
+    /** Background thread: writes queued bytes to the trace file. */
+    int useTimeSlice() override;
+
+private:
+    static constexpr int ringBytes = 8 * 1024 * 1024;
+
+    std::vector<char> storage;
+    juce::AbstractFifo fifo { 1 };
+    std::atomic<bool> capturing { false };
+    std::atomic<bool> writing { false };   // Set while captureBlock() may touch the ring
+    std::atomic<bool> overflowed { false };
+
+    SessionTrace::Header header;
+    std::vector<float> silence;  // Pads channels the host didn't provide
+
+    std::unique_ptr<juce::FileOutputStream> stream;
+    juce::CriticalSection streamLock;
+
+    void drain();
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SessionRecorder)
+};
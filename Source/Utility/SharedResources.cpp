@@ -0,0 +1,43 @@
+//
+// Process-wide resources shared by all plugin instances
+//
+
+#include "SharedResources.h"
+
+SharedResources::SharedResources()
+{
+    ioThread.startThread(juce::Thread::Priority::background);
+}
+
+SharedResources::~SharedResources()
+{
+    if (workerPool != nullptr)
+        workerPool->removeAllJobs(true, 2000);
+
+    ioThread.stopThread(2000);
+}
+
+const juce::dsp::WindowingFunction<float>& SharedResources::getHannWindow(int size)
+{
+    const juce::ScopedLock sl(lock);
+
+    auto& window = windows[size];
+    if (window == nullptr)
+        window = std::make_unique<juce::dsp::WindowingFunction<float>>(static_cast<size_t>(size),
+                                                                       juce::dsp::WindowingFunction<float>::hann,
+                                                                       false);
+
+    return *window;
+}
+
+juce::ThreadPool& SharedResources::getWorkerPool()
+{
+    const juce::ScopedLock sl(lock);
+
+    if (workerPool == nullptr)
+        workerPool = std::make_unique<juce::ThreadPool>(juce::ThreadPoolOptions{}
+                                                            .withThreadName("SpectralShift Worker")
+                                                            .withNumberOfThreads(juce::SystemStats::getNumCpus()));
+
+    return *workerPool;
+}
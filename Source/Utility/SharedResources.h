@@ -0,0 +1,54 @@
+//
+// Process-wide resources shared by all plugin instances
+//
+
+#pragma once
+#include <juce_dsp/juce_dsp.h>
+#include <map>
+#include <memory>
+
+/**
+ * Read-only DSP tables and threads shared by every instance in the process.
+ *
+ * Hold a juce::SharedResourcePointer<SharedResources>: the object is created
+ * with the first instance and destroyed with the last, so a session with many
+ * instances keeps one copy of each window table and a fixed number of threads
+ * instead of a set per instance.
+ *
+ * - Hann windows are created on first request per size and never change
+ *   afterwards; multiplyWithWindowingTable only reads the table, so the audio
+ *   threads of different instances can use one concurrently. Request them from
+ *   prepare(), never from the audio thread.
+ * - FFT plans are deliberately not shared. juce::dsp::FFT's fallback engine
+ *   (used unless JUCE is built with IPP, FFTW or on Apple's vDSP) serialises
+ *   perform() through a SpinLock around its scratch buffer, so instances on
+ *   different audio threads would contend; each analyser owns its own plan.
+ * - The IO thread runs the watchdog log, session recorder and other
+ *   TimeSliceClients at background priority.
+ * - The worker pool has one thread per core for background jobs such as
+ *   engine builds and preset scans. It is created on first use.
+ */
+class SharedResources
+{
+public:
+    SharedResources();
+    ~SharedResources();
+
+    /** Shared non-normalised Hann window of the given size. */
+    const juce::dsp::WindowingFunction<float>& getHannWindow(int size);
+
+    /** Background thread for file IO, started on construction. */
+    juce::TimeSliceThread& getIOThread() { return ioThread; }
+
+    /** Pool of background workers, one per core. */
+    juce::ThreadPool& getWorkerPool();
+
+private:
+    juce::CriticalSection lock;
+    std::map<int, std::unique_ptr<juce::dsp::WindowingFunction<float>>> windows;
+
+    juce::TimeSliceThread ioThread { "SpectralShift IO" };
+    std::unique_ptr<juce::ThreadPool> workerPool;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SharedResources)
+};
@@ -0,0 +1,60 @@
+//
+// Bounded single-producer, single-consumer queue
+//
+
+#pragma once
+#include <juce_core/juce_core.h>
+#include <array>
+
+/**
+ * Fixed-capacity, wait-free queue for handing values between exactly two
+ * threads (one pushing, one popping).
+ *
+ * Storage is preallocated and values are moved in and out of their slots,
+ * so neither side allocates, locks or blocks. push() fails rather than
+ * waits when the queue is full. T must be default constructible and
+ * nothrow move assignable; a popped slot is reset to T{} so the queue
+ * never keeps a moved-from resource alive.
+ *
+ * Holds up to capacity - 1 values.
+ */
+template <typename T, int capacity>
+class SpscQueue
+{
+public:
+    static_assert(capacity > 1);
+    static_assert(std::is_nothrow_move_assignable_v<T>);
+
+    /** Producer: moves value into the queue. Returns false (leaving value untouched) when full. */
+    bool push(T& value) noexcept
+    {
+        const auto scope = fifo.write(1);
+        if (scope.blockSize1 == 0)
+            return false;
+
+        slots[static_cast<size_t>(scope.startIndex1)] = std::move(value);
+        return true;
+    }
+
+    bool push(T&& value) noexcept { return push(value); }
+
+    /** Consumer: moves the oldest value into result. Returns false when empty. */
+    bool pop(T& result) noexcept
+    {
+        const auto scope = fifo.read(1);
+        if (scope.blockSize1 == 0)
+            return false;
+
+        auto& slot = slots[static_cast<size_t>(scope.startIndex1)];
+        result = std::move(slot);
+        slot = T {};
+        return true;
+    }
+
+    /** Either thread: number of values waiting. */
+    int getNumReady() const noexcept { return fifo.getNumReady(); }
+
+private:
+    juce::AbstractFifo fifo { capacity };
+    std::array<T, capacity> slots {};
+};
@@ -0,0 +1,223 @@
+//
+// Per-stage DSP profiler
+//
+
+#pragma once
+#include <juce_core/juce_core.h>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+
+/**
+ * Always-compiled, low-overhead per-stage timing profiler.
+ *
+ * Each stage of processBlock records its duration (steady_clock) into a
+ * lock-free log-spaced histogram, from which p50/p99/max can be read on any
+ * thread. This works in release builds without Perfetto.
+ *
+ * Implementation details:
+ * - One writer (the audio thread), any number of readers
+ * - 4 buckets per octave from 64 ns to ~67 ms (80 buckets, ~19% resolution)
+ * - Bucket index from the leading bit position, no log() on the audio thread
+ * - Resets are requested by readers and applied by the audio thread at the
+ *   start of the next block, so counters only ever have a single writer
+ *
+ * Cost when enabled is two clock reads and one relaxed increment per stage.
+ */
+class StageProfiler
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    enum class Stage : int
+    {
+        Block,
+        ParameterUpdate,
+        PitchTracker,
+        SignalsmithStretch,
+        BufferCopy,
+        MonoSum,
+        SpectralCentroid,
+        TiltEQ,
+        NumStages
+    };
+
+    static constexpr int numStages = static_cast<int> (Stage::NumStages);
+
+    struct Summary
+    {
+        double p50Ms = 0.0;
+        double p99Ms = 0.0;
+        double maxMs = 0.0;
+        uint64_t count = 0;
+    };
+
+    static const char* getStageName (Stage stage)
+    {
+        static constexpr std::array<const char*, numStages> names {
+            "block", "parameter-update", "pitch-tracker", "signalsmith-stretch",
+            "buffer-copy", "mono-sum", "spectral-centroid", "tilt-eq"
+        };
+        return names[static_cast<size_t> (stage)];
+    }
+
+    /** Times the enclosing scope into a stage. Does nothing while the profiler is disabled. */
+    class ScopedStage
+    {
+    public:
+        ScopedStage (StageProfiler& p, Stage s) noexcept
+            : profiler (p.isEnabled() ? &p : nullptr), stage (s)
+        {
+            if (profiler != nullptr)
+                start = Clock::now();
+        }
+
+        ~ScopedStage()
+        {
+            if (profiler != nullptr)
+                profiler->record (stage, static_cast<uint64_t> (
+                    std::chrono::duration_cast<std::chrono::nanoseconds> (Clock::now() - start).count()));
+        }
+
+    private:
+        StageProfiler* profiler;
+        Stage stage;
+        Clock::time_point start {};
+
+        JUCE_DECLARE_NON_COPYABLE (ScopedStage)
+    };
+
+    void setEnabled (bool shouldBeEnabled) noexcept { enabled.store (shouldBeEnabled, std::memory_order_relaxed); }
+    bool isEnabled() const noexcept { return enabled.load (std::memory_order_relaxed); }
+
+    /** Any thread: asks the audio thread to clear all histograms at the next block. */
+    void requestReset() noexcept { resetRequested.store (true, std::memory_order_release); }
+
+    /** Audio thread: call once at the top of each block. */
+    void beginBlock() noexcept
+    {
+        blockNs.fill (0);
+
+        if (resetRequested.exchange (false, std::memory_order_acquire))
+        {
+            for (auto& histogram : histograms)
+            {
+                for (auto& bucket : histogram.buckets)
+                    bucket.store (0, std::memory_order_relaxed);
+                histogram.count.store (0, std::memory_order_relaxed);
+                histogram.maxNs.store (0, std::memory_order_relaxed);
+                histogram.lastNs.store (0, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /** Audio thread: records one duration for a stage. */
+    void record (Stage stage, uint64_t nanoseconds) noexcept
+    {
+        auto& histogram = histograms[static_cast<size_t> (stage)];
+        auto& bucket = histogram.buckets[static_cast<size_t> (bucketIndex (nanoseconds))];
+
+        // Single writer, so load/store is enough and avoids locked read-modify-writes
+        bucket.store (bucket.load (std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        histogram.count.store (histogram.count.load (std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+        if (nanoseconds > histogram.maxNs.load (std::memory_order_relaxed))
+            histogram.maxNs.store (nanoseconds, std::memory_order_relaxed);
+
+        histogram.lastNs.store (nanoseconds, std::memory_order_relaxed);
+        blockNs[static_cast<size_t> (stage)] += nanoseconds;
+    }
+
+    /** Any thread: the most recent duration recorded for a stage. */
+    double getLastMs (Stage stage) const noexcept
+    {
+        return static_cast<double> (histograms[static_cast<size_t> (stage)].lastNs.load (std::memory_order_relaxed)) * 1.0e-6;
+    }
+
+    /** Audio thread: total time recorded for a stage since beginBlock(); 0 if it didn't run this block. */
+    double getBlockMs (Stage stage) const noexcept
+    {
+        return static_cast<double> (blockNs[static_cast<size_t> (stage)]) * 1.0e-6;
+    }
+
+    /** Any thread: percentiles for a stage since the last reset. */
+    Summary getSummary (Stage stage) const noexcept
+    {
+        const auto& histogram = histograms[static_cast<size_t> (stage)];
+
+        std::array<uint32_t, numBuckets> counts {};
+        uint64_t total = 0;
+        for (int i = 0; i < numBuckets; ++i)
+        {
+            counts[static_cast<size_t> (i)] = histogram.buckets[static_cast<size_t> (i)].load (std::memory_order_relaxed);
+            total += counts[static_cast<size_t> (i)];
+        }
+
+        Summary summary;
+        summary.count = total;
+        summary.maxMs = static_cast<double> (histogram.maxNs.load (std::memory_order_relaxed)) * 1.0e-6;
+
+        if (total == 0)
+            return summary;
+
+        summary.p50Ms = percentileMs (counts, total, 0.50);
+        summary.p99Ms = juce::jmin (percentileMs (counts, total, 0.99), summary.maxMs);
+        summary.p50Ms = juce::jmin (summary.p50Ms, summary.maxMs);
+        return summary;
+    }
+
+private:
+    static constexpr int bucketsPerOctave = 4;
+    static constexpr int minOctave = 6;    // 2^6 = 64 ns
+    static constexpr int numOctaves = 20;  // up to 2^26 ns (~67 ms)
+    static constexpr int numBuckets = bucketsPerOctave * numOctaves;
+
+    struct Histogram
+    {
+        std::array<std::atomic<uint32_t>, numBuckets> buckets {};
+        std::atomic<uint64_t> count { 0 };
+        std::atomic<uint64_t> maxNs { 0 };
+        std::atomic<uint64_t> lastNs { 0 };
+    };
+
+    std::array<Histogram, numStages> histograms;
+    std::array<uint64_t, numStages> blockNs {};  // Audio thread only
+    std::atomic<bool> enabled { true };
+    std::atomic<bool> resetRequested { false };
+
+    static int bucketIndex (uint64_t ns) noexcept
+    {
+        if (ns < (uint64_t { 1 } << minOctave))
+            return 0;
+
+        const int octave = static_cast<int> (std::bit_width (ns)) - 1;
+        const int subBucket = static_cast<int> ((ns >> (octave - 2)) & 3);
+        return juce::jmin (numBuckets - 1, (octave - minOctave) * bucketsPerOctave + subBucket);
+    }
+
+    /** Upper edge of a bucket in milliseconds. */
+    static double bucketUpperMs (int index) noexcept
+    {
+        const int octave = minOctave + index / bucketsPerOctave;
+        const int subBucket = index % bucketsPerOctave;
+        const double lower = std::ldexp (1.0 + subBucket / static_cast<double> (bucketsPerOctave), octave);
+        const double width = std::ldexp (1.0 / bucketsPerOctave, octave);
+        return (lower + width) * 1.0e-6;
+    }
+
+    static double percentileMs (const std::array<uint32_t, numBuckets>& counts, uint64_t total, double fraction) noexcept
+    {
+        const auto target = static_cast<uint64_t> (std::ceil (fraction * static_cast<double> (total)));
+        uint64_t cumulative = 0;
+
+        for (int i = 0; i < numBuckets; ++i)
+        {
+            cumulative += counts[static_cast<size_t> (i)];
+            if (cumulative >= target)
+                return bucketUpperMs (i);
+        }
+
+        return bucketUpperMs (numBuckets - 1);
+    }
+};
@@ -0,0 +1,103 @@
+//
+// Audio-to-UI telemetry channel
+//
+
+#pragma once
+#include <juce_core/juce_core.h>
+#include <array>
+#include <atomic>
+
+/**
+ * Lock-free telemetry channel from the audio thread to the editor.
+ *
+ * The audio thread publishes one snapshot per block. The latest values are
+ * kept in relaxed atomics for cheap polling, and every snapshot is also
+ * pushed into a single-producer/single-consumer ring so the editor can
+ * consume the history (e.g. for meters) without missing blocks.
+ *
+ * Nothing here touches host parameters, so live analysis values never end
+ * up in automation lanes.
+ */
+class Telemetry
+{
+public:
+    struct Snapshot
+    {
+        float centroidHz = 0.0f;      // Smoothed spectral centroid of the output
+        float tiltCentreHz = 0.0f;    // Tilt centre actually applied this block
+        int latencySamples = 0;       // Latency reported to the host
+        float load = 0.0f;            // Processing load (0..1 of the block deadline)
+        float blockMs = 0.0f;         // Processing time of this block
+        float deadlineMs = 0.0f;      // Real-time duration of this block
+        float sampleRate = 0.0f;
+        uint64_t flowId = 0;          // Perfetto flow linking this block to the consumer (0 = none)
+    };
+
+    /** Audio thread: publishes a snapshot. Drops it from the ring if the UI isn't draining. */
+    void publish (const Snapshot& snapshot) noexcept
+    {
+        centroidHz.store (snapshot.centroidHz, std::memory_order_relaxed);
+        tiltCentreHz.store (snapshot.tiltCentreHz, std::memory_order_relaxed);
+        latencySamples.store (snapshot.latencySamples, std::memory_order_relaxed);
+        load.store (snapshot.load, std::memory_order_relaxed);
+        blockMs.store (snapshot.blockMs, std::memory_order_relaxed);
+        deadlineMs.store (snapshot.deadlineMs, std::memory_order_relaxed);
+        sampleRate.store (snapshot.sampleRate, std::memory_order_relaxed);
+
+        if (snapshot.blockMs > snapshot.deadlineMs && snapshot.deadlineMs > 0.0f)
+            overruns.store (overruns.load (std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+        const auto scope = fifo.write (1);
+        if (scope.blockSize1 > 0)
+            ring[static_cast<size_t> (scope.startIndex1)] = snapshot;
+    }
+
+    /** Any thread: returns the most recently published values. */
+    Snapshot getLatest() const noexcept
+    {
+        return { centroidHz.load (std::memory_order_relaxed),
+                 tiltCentreHz.load (std::memory_order_relaxed),
+                 latencySamples.load (std::memory_order_relaxed),
+                 load.load (std::memory_order_relaxed),
+                 blockMs.load (std::memory_order_relaxed),
+                 deadlineMs.load (std::memory_order_relaxed),
+                 sampleRate.load (std::memory_order_relaxed) };
+    }
+
+    /** Any thread: number of snapshots waiting in the ring. */
+    int getNumQueued() const noexcept { return fifo.getNumReady(); }
+
+    /** Any thread: number of blocks whose processing time exceeded their real-time duration. */
+    uint32_t getOverrunCount() const noexcept
+    {
+        return overruns.load (std::memory_order_relaxed);
+    }
+
+    /** UI thread: pops up to maxSnapshots queued snapshots, oldest first. Returns the count. */
+    int pop (Snapshot* dest, int maxSnapshots) noexcept
+    {
+        const auto scope = fifo.read (juce::jmin (maxSnapshots, fifo.getNumReady()));
+
+        for (int i = 0; i < scope.blockSize1; ++i)
+            dest[i] = ring[static_cast<size_t> (scope.startIndex1 + i)];
+        for (int i = 0; i < scope.blockSize2; ++i)
+            dest[scope.blockSize1 + i] = ring[static_cast<size_t> (scope.startIndex2 + i)];
+
+        return scope.blockSize1 + scope.blockSize2;
+    }
+
+private:
+    static constexpr int capacity = 64;
+
+    std::atomic<float> centroidHz { 0.0f };
+    std::atomic<float> tiltCentreHz { 0.0f };
+    std::atomic<int> latencySamples { 0 };
+    std::atomic<float> load { 0.0f };
+    std::atomic<float> blockMs { 0.0f };
+    std::atomic<float> deadlineMs { 0.0f };
+    std::atomic<float> sampleRate { 0.0f };
+    std::atomic<uint32_t> overruns { 0 };   // Single writer (audio thread)
+
+    juce::AbstractFifo fifo { capacity };
+    std::array<Snapshot, capacity> ring {};
+};
@@ -0,0 +1,26 @@
+//
+// Perfetto tracing helpers
+//
+
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+#if PERFETTO
+    #include <melatonin_perfetto/melatonin_perfetto.h>
+#endif
+
+namespace Tracing
+{
+    /**
+     * Returns a process-wide unique id for a Perfetto flow, used to link an
+     * audio block to the work it hands to other threads (telemetry drained by
+     * the editor, watchdog records written by the IO thread). Shared by all
+     * plugin instances so flows never collide.
+     */
+    inline uint64_t nextFlowId() noexcept
+    {
+        static std::atomic<uint64_t> next { 1 };
+        return next.fetch_add(1, std::memory_order_relaxed);
+    }
+}
@@ -0,0 +1,1053 @@
+//
+// Offline tools for Spectral Shift
+//
+// replay: pushes a recorded session trace through a fresh processor with the
+// stage profiler on, so host-dependent CPU spikes can be reproduced and
+// bisected deterministically.
+//
+// render: processes a whole audio file at a fixed block size, optionally with
+// parameter overrides, so output and timings can be captured without a DAW.
+//
+// stress: runs processBlock on its own thread while the main thread hammers
+// preset changes, resets and parameter moves, to exercise the command queue
+// (build with -fsanitize=thread to check for races).
+//
+// bench-prepare: times prepareToPlay cold, repeated with the same settings (as
+// on transport start) and with a changed block size.
+//
+// bench-state: times getStateInformation/setStateInformation per instance for
+// the binary state format and for the legacy XML format it replaced.
+//
+// bench-session: loads a session of many instances the way hosts do (restore
+// state, prepare, restore again, prepare again, first block) and times it, once
+// with the XML state replaced immediately (as before) and once with the
+// current setStateInformation.
+//
+// bench-instantiate: instances constructed per second, and the time to open an
+// editor (construct, build the controls, lay out and paint once).
+//
+// bench-pitch: checks the YIN tracker against known-f0 sines and a full-rate
+// reference on the bundled recording, and times it against the centroid analyser.
+//
+// bench-tilt: checks the merged SIMD tilt against the original pair of
+// duplicated IIR shelves and times both per sample.
+//
+// bench-quantum: times the stretch engine fed whole host blocks against the
+// same audio split into 64-sample sub-blocks, with and without a pitch sweep.
+//
+// replay and render accept --trace <file> to write a Perfetto trace of the run
+// (requires a -DPERFETTO=ON build).
+//
+
+#include <juce_core/juce_core.h>
+#include <juce_audio_formats/juce_audio_formats.h>
+#include "../../Source/PluginProcessor.h"
+#include "../../Source/PluginEditor.h"
+#include "../../Source/Utility/SessionRecorder.h"
+#include <thread>
+
+namespace
+{
+    void printUsage()
+    {
+        std::cout << "Usage:\n"
+                  << "  SpectralShiftOffline replay <trace.sstrace> [--repeat N] [--trace out.perfetto-trace]\n"
+                  << "  SpectralShiftOffline render <in.wav> <out.wav> [--block N] [--param ID=value ...]\n"
+                  << "                              [--trace out.perfetto-trace]\n"
+                  << "  SpectralShiftOffline bench-prepare [--rate Hz] [--block N] [--repeat N]\n"
+                  << "  SpectralShiftOffline stress [--seconds N] [--block N]\n"
+                  << "  SpectralShiftOffline bench-state [--repeat N]\n"
+                  << "  SpectralShiftOffline bench-session [--instances N] [--rate Hz] [--block N]\n"
+                  << "  SpectralShiftOffline bench-instantiate [--count N]\n"
+                  << "  SpectralShiftOffline bench-pitch [--file recording.flac]\n"
+                  << "  SpectralShiftOffline bench-tilt [--rate Hz] [--block N]\n"
+                  << "  SpectralShiftOffline bench-quantum [--rate Hz] [--block N] [--quantum N]\n";
+    }
+
+    /** Returns the value following a flag, or an empty string. */
+    juce::String getOption (const juce::StringArray& args, const juce::String& flag)
+    {
+        const int index = args.indexOf (flag);
+        return index >= 0 && index + 1 < args.size() ? args[index + 1] : juce::String();
+    }
+
+    juce::File resolve (const juce::String& path)
+    {
+        return juce::File::getCurrentWorkingDirectory().getChildFile (path);
+    }
+
+    /** Writes the processor's Perfetto session to traceFile, if one was requested. */
+    bool finishTrace (SpectralShiftAudioProcessor& processor, const juce::File& traceFile)
+    {
+        if (traceFile == juce::File())
+            return true;
+
+       #if PERFETTO
+        if (processor.writePerfettoTrace (traceFile))
+        {
+            std::cout << "Wrote " << traceFile.getFullPathName() << "\n";
+            return true;
+        }
+
+        std::cerr << "Could not write " << traceFile.getFullPathName() << "\n";
+        return false;
+       #else
+        juce::ignoreUnused (processor);
+        std::cerr << "--trace needs a build configured with -DPERFETTO=ON\n";
+        return false;
+       #endif
+    }
+
+    void printStageSummaries (const StageProfiler& profiler)
+    {
+        std::cout << juce::String ("stage").paddedRight (' ', 22)
+                  << juce::String ("count").paddedLeft (' ', 10)
+                  << juce::String ("p50 ms").paddedLeft (' ', 10)
+                  << juce::String ("p99 ms").paddedLeft (' ', 10)
+                  << juce::String ("max ms").paddedLeft (' ', 10) << "\n";
+
+        for (int i = 0; i < StageProfiler::numStages; ++i)
+        {
+            const auto stage = static_cast<StageProfiler::Stage> (i);
+            const auto summary = profiler.getSummary (stage);
+
+            std::cout << juce::String (StageProfiler::getStageName (stage)).paddedRight (' ', 22)
+                      << juce::String (static_cast<juce::int64> (summary.count)).paddedLeft (' ', 10)
+                      << juce::String (summary.p50Ms, 3).paddedLeft (' ', 10)
+                      << juce::String (summary.p99Ms, 3).paddedLeft (' ', 10)
+                      << juce::String (summary.maxMs, 3).paddedLeft (' ', 10) << "\n";
+        }
+    }
+
+    /** Applies a plain-value parameter snapshot the same way host automation would. */
+    void applyParameters (SpectralShiftAudioProcessor& processor, const std::array<float, numParams>& params)
+    {
+        for (int i = 0; i < numParams; ++i)
+        {
+            if (auto* parameter = processor.apvts.getParameter (paramIDs[static_cast<size_t> (i)]))
+            {
+                const float normalised = parameter->convertTo0to1 (params[static_cast<size_t> (i)]);
+                if (parameter->getValue() != normalised)
+                    parameter->setValueNotifyingHost (normalised);
+            }
+        }
+    }
+
+    /**
+     * Restores a copyXmlToBinary block the way setStateInformation did before the binary
+     * state: parse the XML and replace the whole APVTS state, applied immediately.
+     * (AudioProcessor::getXmlFromBinary isn't reachable from here; the block is an 8-byte
+     * header followed by null-terminated UTF-8.)
+     */
+    void replaceStateFromXml (SpectralShiftAudioProcessor& processor, const juce::MemoryBlock& block)
+    {
+        if (block.getSize() <= 8)
+            return;
+
+        if (const auto xml = juce::XmlDocument::parse (juce::String::fromUTF8 (static_cast<const char*> (block.getData()) + 8)))
+            processor.apvts.replaceState (juce::ValueTree::fromXml (*xml));
+    }
+
+    int replay (const juce::File& traceFile, int repeats, const juce::File& perfettoFile)
+    {
+        juce::FileInputStream in (traceFile);
+        SessionTrace::Header header;
+
+        if (! in.openedOk() || ! SessionTrace::readHeader (in, header))
+        {
+            std::cerr << "Not a compatible session trace: " << traceFile.getFullPathName() << "\n";
+            return 1;
+        }
+
+        std::cout << "Trace: " << header.sampleRate << " Hz, " << header.numChannels << " ch, max block "
+                  << header.maxBlockSize << (header.hasAudio ? ", with audio" : ", no audio (noise input)") << "\n";
+
+        SpectralShiftAudioProcessor processor;
+        const auto layout = header.numChannels == 1 ? juce::AudioChannelSet::mono() : juce::AudioChannelSet::stereo();
+        processor.setBusesLayout ({ { layout }, { layout } });
+        processor.setRateAndBufferSizeDetails (header.sampleRate, header.maxBlockSize);
+        processor.getProfiler().setEnabled (true);
+
+        const auto blocksStart = in.getPosition();
+        std::array<float, numParams> params {};
+        juce::AudioBuffer<float> audio;
+        juce::MidiBuffer midi;
+        juce::int64 numBlocks = 0;
+
+        for (int pass = 0; pass < repeats; ++pass)
+        {
+            // Each pass starts from a freshly prepared processor and the same input
+            in.setPosition (blocksStart);
+            juce::Random noise (1);
+            processor.prepareToPlay (header.sampleRate, header.maxBlockSize);
+
+            int numSamples = 0;
+            while (SessionTrace::readBlock (in, header, numSamples, params, audio))
+            {
+                if (! header.hasAudio)
+                    for (int ch = 0; ch < audio.getNumChannels(); ++ch)
+                        for (int i = 0; i < numSamples; ++i)
+                            audio.setSample (ch, i, (noise.nextFloat() * 2.0f - 1.0f) * 0.25f);
+
+                applyParameters (processor, params);
+                processor.processBlock (audio, midi);
+                ++numBlocks;
+            }
+
+            processor.releaseResources();
+        }
+
+        std::cout << "Replayed " << numBlocks << " blocks over " << repeats << " pass(es)\n\n";
+        printStageSummaries (processor.getProfiler());
+        return finishTrace (processor, perfettoFile) ? 0 : 1;
+    }
+
+    int render (const juce::File& inputFile, const juce::File& outputFile, int blockSize,
+                const juce::StringArray& paramOverrides, const juce::File& perfettoFile)
+    {
+        juce::AudioFormatManager formatManager;
+        formatManager.registerBasicFormats();
+
+        std::unique_ptr<juce::AudioFormatReader> reader (formatManager.createReaderFor (inputFile));
+        if (reader == nullptr)
+        {
+            std::cerr << "Could not read " << inputFile.getFullPathName() << "\n";
+            return 1;
+        }
+
+        const int numChannels = juce::jlimit (1, 2, static_cast<int> (reader->numChannels));
+        const double sampleRate = reader->sampleRate;
+        const auto lengthInSamples = reader->lengthInSamples;
+
+        SpectralShiftAudioProcessor processor;
+        const auto layout = numChannels == 1 ? juce::AudioChannelSet::mono() : juce::AudioChannelSet::stereo();
+        processor.setBusesLayout ({ { layout }, { layout } });
+        processor.setRateAndBufferSizeDetails (sampleRate, blockSize);
+        processor.getProfiler().setEnabled (true);
+
+        for (const auto& assignment : paramOverrides)
+        {
+            auto* parameter = processor.apvts.getParameter (assignment.upToFirstOccurrenceOf ("=", false, false));
+            if (parameter == nullptr)
+            {
+                std::cerr << "Unknown parameter: " << assignment << "\n";
+                return 1;
+            }
+
+            parameter->setValueNotifyingHost (parameter->convertTo0to1 (assignment.fromFirstOccurrenceOf ("=", false, false).getFloatValue()));
+        }
+
+        processor.prepareToPlay (sampleRate, blockSize);
+
+        outputFile.deleteFile();
+        auto outStream = std::make_unique<juce::FileOutputStream> (outputFile);
+        juce::WavAudioFormat wav;
+        std::unique_ptr<juce::AudioFormatWriter> writer (
+            outStream->openedOk() ? wav.createWriterFor (outStream.get(), sampleRate, static_cast<unsigned int> (numChannels), 24, {}, 0) : nullptr);
+
+        if (writer == nullptr)
+        {
+            std::cerr << "Could not write " << outputFile.getFullPathName() << "\n";
+            return 1;
+        }
+        outStream.release();  // Owned by the writer now
+
+        // Run past the end by the latency, and drop the leading latency, so the output lines up with the input
+        const int latency = processor.getLatencySamples();
+        const auto totalSamples = lengthInSamples + latency;
+
+        juce::AudioBuffer<float> buffer (numChannels, blockSize);
+        juce::MidiBuffer midi;
+        juce::int64 skipped = 0;
+        juce::int64 numBlocks = 0;
+
+        for (juce::int64 position = 0; position < totalSamples; position += blockSize)
+        {
+            const int numSamples = static_cast<int> (juce::jmin (static_cast<juce::int64> (blockSize), totalSamples - position));
+            buffer.setSize (numChannels, numSamples, false, false, true);
+            buffer.clear();
+
+            if (position < lengthInSamples)
+                reader->read (&buffer, 0, static_cast<int> (juce::jmin (static_cast<juce::int64> (numSamples), lengthInSamples - position)),
+                              position, true, numChannels > 1);
+
+            processor.processBlock (buffer, midi);
+            ++numBlocks;
+
+            const int skip = static_cast<int> (juce::jmin (static_cast<juce::int64> (numSamples), latency - skipped));
+            skipped += skip;
+            if (skip < numSamples)
+                writer->writeFromAudioSampleBuffer (buffer, skip, numSamples - skip);
+        }
+
+        writer.reset();
+        processor.releaseResources();
+
+        std::cout << "Rendered " << lengthInSamples << " samples in " << numBlocks << " blocks of " << blockSize << "\n\n";
+        printStageSummaries (processor.getProfiler());
+        return finishTrace (processor, perfettoFile) ? 0 : 1;
+    }
+
+    int stress (double seconds, int blockSize)
+    {
+        constexpr double sampleRate = 48000.0;
+
+        SpectralShiftAudioProcessor processor;
+        processor.setRateAndBufferSizeDetails (sampleRate, blockSize);
+        processor.getProfiler().setEnabled (true);
+        processor.prepareToPlay (sampleRate, blockSize);
+
+        std::atomic<bool> running { true };
+        std::atomic<juce::int64> numBlocks { 0 };
+
+        // Stands in for the host's audio thread
+        std::thread audioThread ([&]
+        {
+            juce::AudioBuffer<float> buffer (2, blockSize);
+            juce::MidiBuffer midi;
+            juce::Random noise (1);
+
+            while (running.load())
+            {
+                for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+                    for (int i = 0; i < blockSize; ++i)
+                        buffer.setSample (ch, i, (noise.nextFloat() * 2.0f - 1.0f) * 0.25f);
+
+                processor.processBlock (buffer, midi);
+                numBlocks.fetch_add (1);
+            }
+        });
+
+        juce::Random random (2);
+        juce::int64 numCommands = 0;
+        const auto end = juce::Time::getMillisecondCounterHiRes() + seconds * 1000.0;
+
+        while (juce::Time::getMillisecondCounterHiRes() < end)
+        {
+            switch (random.nextInt (4))
+            {
+                case 0:  processor.setCurrentProgram (random.nextInt (juce::jmax (1, processor.getNumPrograms()))); break;
+                case 1:  processor.reset(); break;
+                case 2:  processor.resetAnalysis(); break;
+                default:
+                {
+                    auto* parameter = processor.apvts.getParameter (paramIDs[static_cast<size_t> (random.nextInt (numParams))]);
+                    parameter->setValueNotifyingHost (random.nextFloat());
+                    break;
+                }
+            }
+
+            ++numCommands;
+            juce::Thread::sleep (random.nextInt (3));
+        }
+
+        running.store (false);
+        audioThread.join();
+        processor.releaseResources();
+
+        std::cout << "Processed " << numBlocks.load() << " blocks of " << blockSize << " alongside "
+                  << numCommands << " control changes; " << processor.getNumDroppedCommands() << " commands dropped\n\n";
+        printStageSummaries (processor.getProfiler());
+        return processor.getNumDroppedCommands() == 0 ? 0 : 1;
+    }
+
+    int benchPrepare (double sampleRate, int blockSize, int repeats)
+    {
+        SpectralShiftAudioProcessor processor;
+        processor.setRateAndBufferSizeDetails (sampleRate, blockSize);
+
+        // Milliseconds taken by one prepareToPlay call
+        auto timePrepare = [&processor, sampleRate] (int block)
+        {
+            const auto start = juce::Time::getHighResolutionTicks();
+            processor.prepareToPlay (sampleRate, block);
+            return juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - start) * 1000.0;
+        };
+
+        auto printRow = [] (const char* name, const std::vector<double>& timesMs)
+        {
+            auto sorted = timesMs;
+            std::sort (sorted.begin(), sorted.end());
+            const auto median = sorted[sorted.size() / 2];
+
+            std::cout << juce::String (name).paddedRight (' ', 22)
+                      << juce::String (static_cast<int> (sorted.size())).paddedLeft (' ', 10)
+                      << juce::String (median, 3).paddedLeft (' ', 12)
+                      << juce::String (sorted.back(), 3).paddedLeft (' ', 12) << "\n";
+        };
+
+        const std::vector<double> cold { timePrepare (blockSize) };
+
+        std::vector<double> same, changed;
+        for (int i = 0; i < repeats; ++i)
+        {
+            processor.releaseResources();
+            same.push_back (timePrepare (blockSize));
+        }
+
+        // Alternating block sizes defeat the cache, so every call rebuilds
+        for (int i = 0; i < repeats; ++i)
+            changed.push_back (timePrepare (i % 2 == 0 ? blockSize * 2 : blockSize));
+
+        std::cout << "prepareToPlay at " << sampleRate << " Hz, block " << blockSize << "\n\n"
+                  << juce::String ("case").paddedRight (' ', 22)
+                  << juce::String ("calls").paddedLeft (' ', 10)
+                  << juce::String ("median ms").paddedLeft (' ', 12)
+                  << juce::String ("max ms").paddedLeft (' ', 12) << "\n";
+
+        printRow ("cold", cold);
+        printRow ("same settings", same);
+        printRow ("changed settings", changed);
+        return 0;
+    }
+
+    int benchState (int repeats)
+    {
+        SpectralShiftAudioProcessor processor;
+
+        // Microseconds per call, median over repeats
+        auto timeMedian = [repeats] (auto&& call)
+        {
+            std::vector<double> timesUs;
+            for (int i = 0; i < repeats; ++i)
+            {
+                const auto start = juce::Time::getHighResolutionTicks();
+                call();
+                timesUs.push_back (juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - start) * 1.0e6);
+            }
+
+            std::sort (timesUs.begin(), timesUs.end());
+            return timesUs[timesUs.size() / 2];
+        };
+
+        juce::MemoryBlock binary;
+        processor.getStateInformation (binary);
+
+        // The format getStateInformation wrote before the binary state
+        juce::MemoryBlock legacy;
+        juce::AudioProcessor::copyXmlToBinary (*processor.apvts.copyState().createXml(), legacy);
+
+        const auto binarySave = timeMedian ([&] { processor.getStateInformation (binary); });
+        const auto binaryLoad = timeMedian ([&] { processor.setStateInformation (binary.getData(), static_cast<int> (binary.getSize())); });
+        const auto legacySave = timeMedian ([&]
+        {
+            juce::MemoryBlock block;
+            juce::AudioProcessor::copyXmlToBinary (*processor.apvts.copyState().createXml(), block);
+        });
+        const auto legacyLoad = timeMedian ([&] { replaceStateFromXml (processor, legacy); });
+
+        auto printRow = [] (const char* name, size_t bytes, double saveUs, double loadUs)
+        {
+            std::cout << juce::String (name).paddedRight (' ', 12)
+                      << juce::String (static_cast<int> (bytes)).paddedLeft (' ', 10)
+                      << juce::String (saveUs, 2).paddedLeft (' ', 12)
+                      << juce::String (loadUs, 2).paddedLeft (' ', 12) << "\n";
+        };
+
+        // The binary load only parses and stages; the legacy row includes applying the values
+        std::cout << "Plugin state, median of " << repeats << " calls\n\n"
+                  << juce::String ("format").paddedRight (' ', 12)
+                  << juce::String ("bytes").paddedLeft (' ', 10)
+                  << juce::String ("save us").paddedLeft (' ', 12)
+                  << juce::String ("load us").paddedLeft (' ', 12) << "\n";
+
+        printRow ("binary", binary.getSize(), binarySave, binaryLoad);
+        printRow ("legacy xml", legacy.getSize(), legacySave, legacyLoad);
+        return 0;
+    }
+
+    int benchSession (int numInstances, double sampleRate, int blockSize)
+    {
+        // The state every instance restores, with non-default values as a real session would hold,
+        // in the binary format and in the XML format sessions used before it
+        juce::MemoryBlock state, legacyState;
+        {
+            SpectralShiftAudioProcessor source;
+            source.getPresetManager().applyPreset (3);
+            source.getStateInformation (state);
+            juce::AudioProcessor::copyXmlToBinary (*source.apvts.copyState().createXml(), legacyState);
+        }
+
+        juce::AudioBuffer<float> buffer (2, blockSize);
+        juce::MidiBuffer midi;
+
+        // Milliseconds to load a session of fresh instances with the given restore call
+        auto loadSession = [&] (auto&& restore)
+        {
+            std::vector<std::unique_ptr<SpectralShiftAudioProcessor>> instances;
+            for (int i = 0; i < numInstances; ++i)
+            {
+                instances.push_back (std::make_unique<SpectralShiftAudioProcessor>());
+                instances.back()->setRateAndBufferSizeDetails (sampleRate, blockSize);
+            }
+
+            const auto start = juce::Time::getHighResolutionTicks();
+
+            // Hosts commonly restore, prepare, restore again and re-prepare before the first block
+            for (auto& processor : instances)
+            {
+                restore (*processor);
+                processor->prepareToPlay (sampleRate, blockSize);
+                restore (*processor);
+                processor->prepareToPlay (sampleRate, blockSize);
+
+                buffer.clear();
+                processor->processBlock (buffer, midi);
+            }
+
+            const auto totalMs = juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - start) * 1000.0;
+
+            for (auto& processor : instances)
+                processor->releaseResources();
+
+            return totalMs;
+        };
+
+        auto printRow = [numInstances] (const char* name, double totalMs)
+        {
+            std::cout << juce::String (name).paddedRight (' ', 34)
+                      << juce::String (totalMs, 2).paddedLeft (' ', 12)
+                      << juce::String (totalMs / numInstances, 3).paddedLeft (' ', 16) << "\n";
+        };
+
+        // Before: every restore replaced the APVTS state from XML straight away
+        const auto beforeMs = loadSession ([&] (SpectralShiftAudioProcessor& processor)
+        {
+            replaceStateFromXml (processor, legacyState);
+        });
+
+        const auto afterMs = loadSession ([&] (SpectralShiftAudioProcessor& processor)
+        {
+            processor.setStateInformation (state.getData(), static_cast<int> (state.getSize()));
+        });
+
+        std::cout << "Session load of " << numInstances << " instances at " << sampleRate << " Hz, block " << blockSize << "\n\n"
+                  << juce::String ("restore").paddedRight (' ', 34)
+                  << juce::String ("total ms").paddedLeft (' ', 12)
+                  << juce::String ("ms per instance").paddedLeft (' ', 16) << "\n";
+
+        printRow ("xml replaceState (before)", beforeMs);
+        printRow ("binary setStateInformation", afterMs);
+        return 0;
+    }
+
+    int benchInstantiate (int count)
+    {
+        auto secondsSince = [] (juce::int64 start)
+        {
+            return juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - start);
+        };
+
+        // The first instance creates the process-wide resources; keep it alive like a host would
+        SpectralShiftAudioProcessor first;
+
+        auto start = juce::Time::getHighResolutionTicks();
+        for (int i = 0; i < count; ++i)
+            SpectralShiftAudioProcessor instance;
+        const auto instantiateSeconds = secondsSince (start);
+
+        double constructSeconds = 0.0, openSeconds = 0.0;
+        juce::Image image (juce::Image::ARGB, 400, 650, true);
+
+        for (int i = 0; i < count; ++i)
+        {
+            start = juce::Time::getHighResolutionTicks();
+            std::unique_ptr<juce::AudioProcessorEditor> editor (first.createEditor());
+            constructSeconds += secondsSince (start);
+
+            // What a host's first show does: build the controls, lay out and paint
+            start = juce::Time::getHighResolutionTicks();
+            if (auto* spectralEditor = dynamic_cast<SpectralShiftAudioProcessorEditor*> (editor.get()))
+                spectralEditor->createControls();
+
+            juce::Graphics g (image);
+            editor->paintEntireComponent (g, true);
+            openSeconds += secondsSince (start);
+        }
+
+        std::cout << "Instantiation: " << juce::String (count / instantiateSeconds, 1) << " instances per second ("
+                  << juce::String (instantiateSeconds * 1000.0 / count, 3) << " ms each, construct + destroy)\n"
+                  << "Editor: construct " << juce::String (constructSeconds * 1000.0 / count, 3) << " ms, first show "
+                  << juce::String (openSeconds * 1000.0 / count, 3) << " ms (mean of " << count << ")\n";
+        return 0;
+    }
+
+    /** Plain YIN at the full sample rate with a long window, as the reference for the FLAC comparison. */
+    float referencePitchHz (const float* x, int windowSize, double sampleRate)
+    {
+        const int maxLag = static_cast<int> (sampleRate / 50.0);
+        const int minLag = static_cast<int> (sampleRate / 1000.0);
+        std::vector<float> difference (static_cast<size_t> (maxLag + 1), 1.0f);
+
+        double energy = 0.0;
+        for (int j = 0; j < windowSize; ++j)
+            energy += x[j] * x[j];
+
+        if (energy < 1.0e-5 * windowSize)
+            return 0.0f;
+
+        double runningSum = 0.0;
+        for (int tau = 1; tau <= maxLag; ++tau)
+        {
+            double d = 0.0;
+            for (int j = 0; j < windowSize; ++j)
+            {
+                const double delta = x[j] - x[j + tau];
+                d += delta * delta;
+            }
+
+            runningSum += d;
+            difference[static_cast<size_t> (tau)] = static_cast<float> (d * tau / (runningSum + 1.0e-12));
+        }
+
+        for (int tau = juce::jmax (2, minLag); tau < maxLag; ++tau)
+        {
+            if (difference[static_cast<size_t> (tau)] < 0.1f)
+            {
+                while (tau + 1 < maxLag && difference[static_cast<size_t> (tau + 1)] < difference[static_cast<size_t> (tau)])
+                    ++tau;
+
+                return static_cast<float> (sampleRate / tau);
+            }
+        }
+
+        return 0.0f;
+    }
+
+    double centsBetween (double a, double b)
+    {
+        return 1200.0 * std::log2 (a / b);
+    }
+
+    int benchPitch (const juce::File& flacFile)
+    {
+        constexpr int blockSize = 512;
+        bool passed = true;
+
+        auto runTracker = [] (PitchTracker& tracker, const float* samples, int numSamples, auto&& onBlock)
+        {
+            for (int start = 0; start < numSamples; start += blockSize)
+            {
+                tracker.processBlock (samples + start, juce::jmin (blockSize, numSamples - start));
+                onBlock (start);
+            }
+        };
+
+        // ===== Known-f0 sines =====
+        {
+            constexpr double sampleRate = 48000.0;
+            const int numSamples = static_cast<int> (sampleRate);
+
+            DspArena arena;
+            arena.prepare (PitchTracker::getArenaBytes (sampleRate), false);
+            PitchTracker tracker;
+            tracker.prepare (sampleRate, blockSize, arena);
+
+            std::vector<float> sine (static_cast<size_t> (numSamples));
+
+            std::cout << "Sines at " << sampleRate << " Hz, 1 s each\n\n"
+                      << juce::String ("f0 Hz").paddedRight (' ', 10)
+                      << juce::String ("tracked Hz").paddedLeft (' ', 12)
+                      << juce::String ("error ct").paddedLeft (' ', 10) << "\n";
+
+            for (const double f0 : { 60.0, 82.4, 110.0, 220.0, 440.0, 660.0, 880.0 })
+            {
+                for (int i = 0; i < numSamples; ++i)
+                    sine[static_cast<size_t> (i)] = 0.5f * static_cast<float> (std::sin (juce::MathConstants<double>::twoPi * f0 * i / sampleRate));
+
+                tracker.reset();
+                runTracker (tracker, sine.data(), numSamples, [] (int) {});
+
+                const double tracked = tracker.getFrequencyHz();
+                const double error = tracked > 0.0 ? centsBetween (tracked, f0) : 1200.0;
+                passed = passed && std::abs (error) < 20.0;
+
+                std::cout << juce::String (f0, 1).paddedRight (' ', 10)
+                          << juce::String (tracked, 2).paddedLeft (' ', 12)
+                          << juce::String (error, 1).paddedLeft (' ', 10) << "\n";
+            }
+        }
+
+        // ===== Bundled recording against a full-rate reference =====
+        juce::AudioFormatManager formatManager;
+        formatManager.registerBasicFormats();
+        std::unique_ptr<juce::AudioFormatReader> reader (formatManager.createReaderFor (flacFile));
+        if (reader == nullptr)
+        {
+            std::cerr << "\nCould not read " << flacFile.getFullPathName() << "\n";
+            return 1;
+        }
+
+        const double sampleRate = reader->sampleRate;
+        const int numSamples = static_cast<int> (reader->lengthInSamples);
+        const int numChannels = static_cast<int> (reader->numChannels);
+
+        juce::AudioBuffer<float> file (numChannels, numSamples);
+        reader->read (&file, 0, numSamples, 0, true, true);
+
+        std::vector<float> mono (static_cast<size_t> (numSamples), 0.0f);
+        for (int ch = 0; ch < numChannels; ++ch)
+            juce::FloatVectorOperations::addWithMultiply (mono.data(), file.getReadPointer (ch), 1.0f / numChannels, numSamples);
+
+        DspArena arena;
+        arena.prepare (PitchTracker::getArenaBytes (sampleRate) + SpectralCentroid::getArenaBytes(), false);
+        PitchTracker tracker;
+        tracker.prepare (sampleRate, blockSize, arena);
+        SpectralCentroid centroid;
+        centroid.prepare (sampleRate, blockSize, arena);
+
+        // The tracker's output trails its input by the analysis window plus smoothing, so each
+        // reference frame is compared with the estimate this long after the frame
+        const int referenceWindow = 2048;
+        const int trackerDelay = static_cast<int> (0.15 * sampleRate);
+        std::vector<double> errors;
+        int referenceVoiced = 0;
+
+        runTracker (tracker, mono.data(), numSamples, [&] (int blockStart)
+        {
+            const int frameStart = blockStart - trackerDelay;
+            if (frameStart < 0 || (blockStart / blockSize) % 4 != 0
+                || frameStart + referenceWindow + static_cast<int> (sampleRate / 50.0) >= numSamples)
+                return;
+
+            const auto reference = referencePitchHz (mono.data() + frameStart, referenceWindow, sampleRate);
+            if (reference <= 0.0f)
+                return;
+
+            ++referenceVoiced;
+            if (tracker.getFrequencyHz() > 0.0f)
+                errors.push_back (std::abs (centsBetween (tracker.getFrequencyHz(), reference)));
+        });
+
+        std::sort (errors.begin(), errors.end());
+        const double medianError = errors.empty() ? 1200.0 : errors[errors.size() / 2];
+        const auto within50 = std::count_if (errors.begin(), errors.end(), [] (double e) { return e < 50.0; });
+        passed = passed && medianError < 50.0;
+
+        std::cout << "\n" << flacFile.getFileName() << ": " << referenceVoiced << " voiced reference frames, median error "
+                  << juce::String (medianError, 1) << " ct, "
+                  << juce::String (errors.empty() ? 0.0 : 100.0 * static_cast<double> (within50) / static_cast<double> (errors.size()), 1)
+                  << "% within 50 ct\n";
+
+        // ===== Cost against the centroid analyser on the same audio =====
+        auto nsPerSample = [&] (auto&& process)
+        {
+            constexpr int passes = 5;
+            const auto start = juce::Time::getHighResolutionTicks();
+            for (int pass = 0; pass < passes; ++pass)
+                for (int s = 0; s < numSamples; s += blockSize)
+                    process (mono.data() + s, juce::jmin (blockSize, numSamples - s));
+
+            return juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - start) * 1.0e9
+                 / (static_cast<double> (passes) * numSamples);
+        };
+
+        const auto pitchCost = nsPerSample ([&] (const float* x, int n) { tracker.processBlock (x, n); });
+        const auto centroidCost = nsPerSample ([&] (const float* x, int n) { centroid.processBlock (x, n); });
+        passed = passed && pitchCost < centroidCost;
+
+        std::cout << "\nCost: pitch tracker " << juce::String (pitchCost, 2) << " ns/sample, centroid "
+                  << juce::String (centroidCost, 2) << " ns/sample (ratio "
+                  << juce::String (pitchCost / centroidCost, 2) << ")\n\n"
+                  << (passed ? "PASS" : "FAIL") << "\n";
+
+        return passed ? 0 : 1;
+    }
+
+    /** The tilt as it was before the SIMD rewrite: RBJ low and high shelves per channel. */
+    struct ReferenceTilt
+    {
+        using Filter = juce::dsp::IIR::Filter<float>;
+        using Coeffs = juce::dsp::IIR::Coefficients<float>;
+        juce::dsp::ProcessorChain<juce::dsp::ProcessorDuplicator<Filter, Coeffs>,
+                                  juce::dsp::ProcessorDuplicator<Filter, Coeffs>> chain;
+
+        void prepare (const juce::dsp::ProcessSpec& spec, float freq, float gainDb)
+        {
+            chain.prepare (spec);
+            *chain.get<0>().state = *Coeffs::makeLowShelf (spec.sampleRate, freq, 0.4f, juce::Decibels::decibelsToGain (-gainDb));
+            *chain.get<1>().state = *Coeffs::makeHighShelf (spec.sampleRate, freq, 0.4f, juce::Decibels::decibelsToGain (gainDb));
+            chain.reset();
+        }
+
+        void process (juce::AudioBuffer<float>& buffer)
+        {
+            juce::dsp::AudioBlock<float> block (buffer);
+            chain.process (juce::dsp::ProcessContextReplacing<float> (block));
+        }
+    };
+
+    int benchTilt (double sampleRate, int blockSize)
+    {
+        constexpr int numChannels = 2;
+        const int numSamples = static_cast<int> (sampleRate) * 2;
+        const juce::dsp::ProcessSpec spec { sampleRate, static_cast<juce::uint32> (blockSize), numChannels };
+
+        juce::AudioBuffer<float> input (numChannels, numSamples);
+        juce::Random random (1234);
+        for (int ch = 0; ch < numChannels; ++ch)
+            for (int i = 0; i < numSamples; ++i)
+                input.setSample (ch, i, random.nextFloat() - 0.5f);
+
+        auto runBlocks = [&] (juce::AudioBuffer<float>& buffer, auto&& process)
+        {
+            for (int start = 0; start < numSamples; start += blockSize)
+            {
+                const int n = juce::jmin (blockSize, numSamples - start);
+                juce::AudioBuffer<float> block (buffer.getArrayOfWritePointers(), numChannels, start, n);
+                process (block);
+            }
+        };
+
+        // ===== Parity with the original filter at static settings =====
+        const std::pair<float, float> settings[] { { 200.0f, 6.0f }, { 1000.0f, -6.0f }, { 1000.0f, 3.0f },
+                                                   { 4000.0f, -4.5f }, { 12000.0f, 6.0f } };
+        constexpr float tolerance = 1.0e-4f;
+        bool passed = true;
+
+        std::cout << "Centre Hz   Gain dB   Max error\n";
+        for (const auto& [freq, gainDb] : settings)
+        {
+            auto expected = input;
+            ReferenceTilt reference;
+            reference.prepare (spec, freq, gainDb);
+            runBlocks (expected, [&] (juce::AudioBuffer<float>& block) { reference.process (block); });
+
+            auto actual = input;
+            TiltEQ tilt;
+            tilt.setCentreFrequency (freq);
+            tilt.setGainDb (gainDb);
+            tilt.prepare (spec);
+            runBlocks (actual, [&] (juce::AudioBuffer<float>& block) { tilt.process (block); });
+
+            float maxError = 0.0f;
+            for (int ch = 0; ch < numChannels; ++ch)
+                for (int i = 0; i < numSamples; ++i)
+                    maxError = juce::jmax (maxError, std::abs (actual.getSample (ch, i) - expected.getSample (ch, i)));
+
+            passed = passed && maxError < tolerance;
+            std::cout << juce::String (freq, 0).paddedRight (' ', 12)
+                      << juce::String (gainDb, 1).paddedRight (' ', 10)
+                      << juce::String (maxError, 8) << "\n";
+        }
+
+        // ===== Per-sample cost, stereo =====
+        auto nsPerSample = [&] (auto&& process)
+        {
+            constexpr int passes = 20;
+            auto buffer = input;
+            const auto start = juce::Time::getHighResolutionTicks();
+            for (int pass = 0; pass < passes; ++pass)
+                runBlocks (buffer, process);
+
+            return juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - start) * 1.0e9
+                 / (static_cast<double> (passes) * numSamples);
+        };
+
+        ReferenceTilt reference;
+        reference.prepare (spec, 1000.0f, 3.0f);
+        TiltEQ tilt;
+        tilt.setCentreFrequency (1000.0f);
+        tilt.setGainDb (3.0f);
+        tilt.prepare (spec);
+
+        const auto referenceCost = nsPerSample ([&] (juce::AudioBuffer<float>& block) { reference.process (block); });
+        const auto tiltCost = nsPerSample ([&] (juce::AudioBuffer<float>& block) { tilt.process (block); });
+        passed = passed && tiltCost < referenceCost;
+
+        std::cout << "\nCost per stereo frame: duplicated IIR " << juce::String (referenceCost, 2) << " ns, merged SIMD "
+                  << juce::String (tiltCost, 2) << " ns (ratio " << juce::String (tiltCost / referenceCost, 2) << ")\n\n"
+                  << (passed ? "PASS" : "FAIL") << "\n";
+
+        return passed ? 0 : 1;
+    }
+
+    int benchQuantum (double sampleRate, int blockSize, int quantum)
+    {
+        constexpr int numChannels = 2;
+        const int numSamples = static_cast<int> (sampleRate) * 10;
+        const float tonalityNorm = static_cast<float> (8000.0 / sampleRate);
+
+        juce::AudioBuffer<float> input (numChannels, numSamples);
+        juce::AudioBuffer<float> output (numChannels, blockSize);
+        juce::Random random (1234);
+        for (int ch = 0; ch < numChannels; ++ch)
+            for (int i = 0; i < numSamples; ++i)
+                input.setSample (ch, i, random.nextFloat() - 0.5f);
+
+        // Pitch for a sample position: a slow +-2 semitone sweep, or a fixed shift
+        auto pitchAt = [sampleRate] (bool sweep, int position)
+        {
+            return sweep ? 2.0f * std::sin (juce::MathConstants<float>::twoPi * 0.5f * static_cast<float> (position / sampleRate))
+                         : 3.0f;
+        };
+
+        // Nanoseconds per stereo frame for one pass over the input
+        auto nsPerSample = [&] (int step, bool sweep)
+        {
+            StretchEngine engine;
+            engine.configure (numChannels, sampleRate, blockSize, StretchEngine::Quality::Default);
+
+            const float* inputs[numChannels] {};
+            float* outputs[numChannels] {};
+
+            const auto start = juce::Time::getHighResolutionTicks();
+            for (int block = 0; block < numSamples; block += blockSize)
+            {
+                const int blockLength = juce::jmin (blockSize, numSamples - block);
+                for (int offset = 0; offset < blockLength; offset += step)
+                {
+                    const int length = juce::jmin (step, blockLength - offset);
+                    for (int ch = 0; ch < numChannels; ++ch)
+                    {
+                        inputs[ch] = input.getReadPointer (ch, block + offset);
+                        outputs[ch] = output.getWritePointer (ch, offset);
+                    }
+
+                    engine.setParameters (pitchAt (sweep, block + offset + length), tonalityNorm, 0.0f, true, 0.0f);
+                    engine.process (inputs, outputs, length);
+                }
+            }
+
+            return juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - start) * 1.0e9
+                 / static_cast<double> (numSamples);
+        };
+
+        auto printRow = [] (const juce::String& name, double ns, double baseline)
+        {
+            std::cout << name.paddedRight (' ', 30)
+                      << juce::String (ns, 1).paddedLeft (' ', 12)
+                      << (juce::String (100.0 * (ns / baseline - 1.0), 1) + "%").paddedLeft (' ', 12) << "\n";
+        };
+
+        const auto wholeStatic = nsPerSample (blockSize, false);
+        const auto wholeSweep = nsPerSample (blockSize, true);
+        const auto splitStatic = nsPerSample (quantum, false);
+        const auto splitSweep = nsPerSample (quantum, true);
+
+        std::cout << "Stretch at " << sampleRate << " Hz, stereo, block " << blockSize << ", quantum " << quantum << "\n\n"
+                  << juce::String ("case").paddedRight (' ', 30)
+                  << juce::String ("ns/frame").paddedLeft (' ', 12)
+                  << juce::String ("overhead").paddedLeft (' ', 12) << "\n";
+
+        printRow ("whole block, fixed pitch", wholeStatic, wholeStatic);
+        printRow ("whole block, pitch sweep", wholeSweep, wholeStatic);
+        printRow (juce::String (quantum) + "-sample quanta, fixed pitch", splitStatic, wholeStatic);
+        printRow (juce::String (quantum) + "-sample quanta, pitch sweep", splitSweep, wholeSweep);
+        return 0;
+    }
+
+}
+
+int main (int argc, char* argv[])
+{
+    const juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    juce::StringArray args;
+    for (int i = 1; i < argc; ++i)
+        args.add (juce::CharPointer_UTF8 (argv[i]));
+
+    const auto traceOption = getOption (args, "--trace");
+    const auto perfettoFile = traceOption.isNotEmpty() ? resolve (traceOption) : juce::File();
+
+    if (args.size() >= 2 && args[0] == "replay")
+    {
+        const int repeats = juce::jmax (1, getOption (args, "--repeat").getIntValue());
+        return replay (resolve (args[1]), repeats, perfettoFile);
+    }
+
+    if (args.size() >= 3 && args[0] == "render")
+    {
+        const auto blockOption = getOption (args, "--block");
+        const int blockSize = blockOption.isNotEmpty() ? juce::jlimit (1, 65536, blockOption.getIntValue()) : 512;
+
+        juce::StringArray paramOverrides;
+        for (int i = 0; i + 1 < args.size(); ++i)
+            if (args[i] == "--param")
+                paramOverrides.add (args[i + 1]);
+
+        return render (resolve (args[1]), resolve (args[2]), blockSize, paramOverrides, perfettoFile);
+    }
+
+    if (args.size() >= 1 && args[0] == "stress")
+    {
+        const auto secondsOption = getOption (args, "--seconds");
+        const auto blockOption = getOption (args, "--block");
+        const double seconds = secondsOption.isNotEmpty() ? juce::jmax (0.1, secondsOption.getDoubleValue()) : 10.0;
+        const int blockSize = blockOption.isNotEmpty() ? juce::jlimit (1, 65536, blockOption.getIntValue()) : 256;
+
+        return stress (seconds, blockSize);
+    }
+
+    if (args.size() >= 1 && args[0] == "bench-prepare")
+    {
+        const auto rateOption = getOption (args, "--rate");
+        const auto blockOption = getOption (args, "--block");
+        const double sampleRate = rateOption.isNotEmpty() ? juce::jlimit (8000.0, 768000.0, rateOption.getDoubleValue()) : 48000.0;
+        const int blockSize = blockOption.isNotEmpty() ? juce::jlimit (1, 65536, blockOption.getIntValue()) : 512;
+        const auto repeatOption = getOption (args, "--repeat");
+        const int repeats = repeatOption.isNotEmpty() ? juce::jmax (1, repeatOption.getIntValue()) : 100;
+
+        return benchPrepare (sampleRate, blockSize, repeats);
+    }
+
+    if (args.size() >= 1 && args[0] == "bench-state")
+    {
+        const auto repeatOption = getOption (args, "--repeat");
+        const int repeats = repeatOption.isNotEmpty() ? juce::jmax (1, repeatOption.getIntValue()) : 1000;
+
+        return benchState (repeats);
+    }
+
+    if (args.size() >= 1 && args[0] == "bench-session")
+    {
+        const auto instancesOption = getOption (args, "--instances");
+        const auto rateOption = getOption (args, "--rate");
+        const auto blockOption = getOption (args, "--block");
+        const int numInstances = instancesOption.isNotEmpty() ? juce::jmax (1, instancesOption.getIntValue()) : 200;
+        const double sampleRate = rateOption.isNotEmpty() ? juce::jlimit (8000.0, 768000.0, rateOption.getDoubleValue()) : 48000.0;
+        const int blockSize = blockOption.isNotEmpty() ? juce::jlimit (1, 65536, blockOption.getIntValue()) : 512;
+
+        return benchSession (numInstances, sampleRate, blockSize);
+    }
+
+    if (args.size() >= 1 && args[0] == "bench-instantiate")
+    {
+        const auto countOption = getOption (args, "--count");
+        const int count = countOption.isNotEmpty() ? juce::jmax (1, countOption.getIntValue()) : 200;
+
+        return benchInstantiate (count);
+    }
+
+    if (args.size() >= 1 && args[0] == "bench-pitch")
+    {
+        const auto fileOption = getOption (args, "--file");
+        return benchPitch (resolve (fileOption.isNotEmpty() ? fileOption
+                                                            : juce::String ("resources/SpectralShiftExample-BarksMultiplePitchFormats.flac")));
+    }
+
+    if (args.size() >= 1 && args[0] == "bench-tilt")
+    {
+        const auto rateOption = getOption (args, "--rate");
+        const auto blockOption = getOption (args, "--block");
+        const double sampleRate = rateOption.isNotEmpty() ? juce::jlimit (8000.0, 768000.0, rateOption.getDoubleValue()) : 48000.0;
+        const int blockSize = blockOption.isNotEmpty() ? juce::jlimit (1, 65536, blockOption.getIntValue()) : 512;
+
+        return benchTilt (sampleRate, blockSize);
+    }
+
+    if (args.size() >= 1 && args[0] == "bench-quantum")
+    {
+        const auto rateOption = getOption (args, "--rate");
+        const auto blockOption = getOption (args, "--block");
+        const auto quantumOption = getOption (args, "--quantum");
+        const double sampleRate = rateOption.isNotEmpty() ? juce::jlimit (8000.0, 768000.0, rateOption.getDoubleValue()) : 48000.0;
+        const int blockSize = blockOption.isNotEmpty() ? juce::jlimit (1, 65536, blockOption.getIntValue()) : 2048;
+        const int quantum = quantumOption.isNotEmpty() ? juce::jlimit (1, blockSize, quantumOption.getIntValue()) : 64;
+
+        return benchQuantum (sampleRate, blockSize, quantum);
+    }
+
+    printUsage();
+    return 1;
+}